@@ -18,6 +18,9 @@ namespace re {
 using int_t = std::ptrdiff_t;
 using uint_t = std::size_t;
 
+// Distance that keeps data written by different threads off a shared line.
+constexpr std::size_t cache_line_size = 64;
+
 template <typename T> constexpr T pi = T(3.141592653589793238462643L);
 
 template <typename T>
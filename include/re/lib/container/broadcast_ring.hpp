@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cassert>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/container/spsc_ring.hpp>
+
+namespace re {
+
+    // Ring for one producer thread and Readers consumers that each read
+    // the whole stream at their own pace, through a cursor of their own.
+    // All of them share a single copy of the samples.
+    //
+    // Counts work as in spsc_ring. The producer can only overwrite what the
+    // slowest reader has consumed. write() stops there and leaves the rest
+    // to the caller. push() drops the rest and counts it, so that a
+    // real-time producer never waits and readers can tell that the stream
+    // has a gap.
+    template <typename T, std::size_t Size, std::size_t Readers>
+    class broadcast_ring {
+        static_assert(Size > 0);
+        static_assert(Readers > 0);
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "elements are handed over by plain copies");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr size_type capacity()
+        const noexcept {
+            return Size;
+        }
+
+        // Producer side.
+
+        size_type writable()
+        noexcept {
+            producer.slowest = slowest_count();
+            return Size - (producer.count.load(std::memory_order_relaxed)
+                           - producer.slowest);
+        }
+
+        std::array<gsl::span<T>, 2> prepare()
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            return wrapped_regions<T, Size>(c.data(), written, writable());
+        }
+
+        void commit(size_type n)
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            assert(n <= Size - (written - producer.slowest));
+            producer.count.store(written + n, std::memory_order_release);
+        }
+
+        // Copies as many values as the slowest reader leaves room for and
+        // returns how many did.
+        size_type write(gsl::span<T const> values)
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            auto space = Size - (written - producer.slowest);
+            if (space < static_cast<size_type>(std::size(values))) {
+                space = writable();
+            }
+
+            auto const n = std::min(
+                space,
+                static_cast<size_type>(std::size(values))
+            );
+            auto first = values.data();
+            for (auto region : wrapped_regions<T, Size>(c.data(), written, n)) {
+                std::copy(first, first + std::size(region), std::begin(region));
+                first += std::size(region);
+            }
+            producer.count.store(written + n, std::memory_order_release);
+            return n;
+        }
+
+        // Like write(), but values that do not fit are dropped and counted
+        // as an overrun.
+        size_type push(gsl::span<T const> values)
+        noexcept {
+            auto const n = write(values);
+            auto const lost = static_cast<size_type>(std::size(values)) - n;
+            if (lost > 0) {
+                overrun.fetch_add(lost, std::memory_order_relaxed);
+            }
+            return n;
+        }
+
+        // Values push() has dropped so far.
+        size_type dropped()
+        const noexcept {
+            return overrun.load(std::memory_order_relaxed);
+        }
+
+        // How far the reader is behind the producer.
+        size_type backlog(size_type reader)
+        const noexcept {
+            assert(reader < Readers);
+            return producer.count.load(std::memory_order_acquire)
+                - cursors[reader].count.load(std::memory_order_acquire);
+        }
+
+        // Consumer side, each reader from its own thread.
+
+        size_type readable(size_type reader)
+        noexcept {
+            assert(reader < Readers);
+            auto& cursor = cursors[reader];
+            cursor.written = producer.count.load(std::memory_order_acquire);
+            return cursor.written - cursor.count.load(std::memory_order_relaxed);
+        }
+
+        std::array<gsl::span<T const>, 2> peek(size_type reader)
+        noexcept {
+            auto const read = cursors[reader].count.load(
+                std::memory_order_relaxed
+            );
+            return wrapped_regions<T const, Size>(
+                c.data(),
+                read,
+                readable(reader)
+            );
+        }
+
+        void consume(size_type reader, size_type n)
+        noexcept {
+            assert(reader < Readers);
+            auto& cursor = cursors[reader];
+            auto const read = cursor.count.load(std::memory_order_relaxed);
+            assert(n <= cursor.written - read);
+            cursor.count.store(read + n, std::memory_order_release);
+        }
+
+        size_type read(size_type reader, gsl::span<T> out)
+        noexcept {
+            assert(reader < Readers);
+            auto& cursor = cursors[reader];
+            auto const read = cursor.count.load(std::memory_order_relaxed);
+            auto available = cursor.written - read;
+            if (available < static_cast<size_type>(std::size(out))) {
+                available = readable(reader);
+            }
+
+            auto const n = std::min(
+                available,
+                static_cast<size_type>(std::size(out))
+            );
+            auto first = out.data();
+            for (auto region : wrapped_regions<T const, Size>(c.data(), read, n)) {
+                first = std::copy(std::cbegin(region), std::cend(region), first);
+            }
+            cursor.count.store(read + n, std::memory_order_release);
+            return n;
+        }
+
+    private:
+        size_type slowest_count()
+        const noexcept {
+            auto slowest = cursors[0].count.load(std::memory_order_acquire);
+            for (auto i = 1u; i < Readers; ++i) {
+                slowest = std::min(
+                    slowest,
+                    cursors[i].count.load(std::memory_order_acquire)
+                );
+            }
+            return slowest;
+        }
+
+        struct alignas(cache_line_size) writer {
+            std::atomic<size_type> count{0};
+            size_type slowest = 0;
+        };
+
+        struct alignas(cache_line_size) cursor {
+            std::atomic<size_type> count{0};
+            size_type written = 0;
+        };
+
+        writer producer;
+        std::array<cursor, Readers> cursors;
+        alignas(cache_line_size) std::atomic<size_type> overrun{0};
+        std::array<T, Size> c{};
+    };
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cassert>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <gsl/span>
+
+#include "indexed_iterator.hpp"
+
+namespace re {
+
+    // History of the last size() values, for lengths known only at run
+    // time. The storage is rounded up to a power of two and addressed by
+    // a 64 bit count of the values ever pushed, so mapping a position to
+    // the storage is a subtraction and a mask with no branch, and the
+    // count never wraps in practice. Starts out filled with copies of a
+    // value.
+    template <typename T, typename Allocator = std::allocator<T>>
+    class dynamic_ring {
+    public:
+        using value_type = T;
+        using reference = T&;
+        using const_reference = T const&;
+        using container_type = std::vector<T, Allocator>;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using index_type = difference_type;
+        using iterator = indexed_iterator<dynamic_ring, false>;
+        using const_iterator = indexed_iterator<dynamic_ring, true>;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        explicit dynamic_ring(
+            size_type n,
+            value_type const& value = value_type(),
+            Allocator const& allocator = Allocator()
+        ) :
+            c(round_up(n), value, allocator),
+            mask(c.size() - 1),
+            n(n),
+            next(n)
+        {
+        }
+
+        size_type size()
+        const noexcept {
+            return n;
+        }
+
+        size_type capacity()
+        const noexcept {
+            return c.size();
+        }
+
+        bool empty()
+        const noexcept {
+            return n == 0;
+        }
+
+        void fill(value_type const& value)
+        noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            std::fill(std::begin(c), std::end(c), value);
+        }
+
+        reference operator[](size_type position)
+        noexcept {
+            return c[position_to_index(position)];
+        }
+
+        const_reference operator[](size_type position)
+        const noexcept {
+            return c[position_to_index(position)];
+        }
+
+        reference at(size_type position) {
+            if (position >= n) {
+                throw std::out_of_range("dynamic_ring");
+            }
+            return (*this)[position];
+        }
+
+        const_reference at(size_type position)
+        const {
+            if (position >= n) {
+                throw std::out_of_range("dynamic_ring");
+            }
+            return (*this)[position];
+        }
+
+        reference front() noexcept { return (*this)[0]; }
+        const_reference front() const noexcept { return (*this)[0]; }
+        reference back() noexcept { return (*this)[n - 1]; }
+        const_reference back() const noexcept { return (*this)[n - 1]; }
+
+        iterator begin() noexcept { return iterator(this, 0); }
+        iterator end() noexcept { return iterator(this, ssize()); }
+        const_iterator begin() const noexcept { return cbegin(); }
+        const_iterator end() const noexcept { return cend(); }
+        const_iterator cbegin() const noexcept {
+            return const_iterator(this, 0);
+        }
+        const_iterator cend() const noexcept {
+            return const_iterator(this, ssize());
+        }
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const noexcept { return crbegin(); }
+        const_reverse_iterator rend() const noexcept { return crend(); }
+        const_reverse_iterator crbegin() const noexcept {
+            return const_reverse_iterator(cend());
+        }
+        const_reverse_iterator crend() const noexcept {
+            return const_reverse_iterator(cbegin());
+        }
+
+        void push_back(value_type const& value)
+        noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            c[next++ & mask] = value;
+        }
+
+        void push_back(value_type&& value)
+        noexcept(std::is_nothrow_move_assignable<T>::value) {
+            c[next++ & mask] = std::move(value);
+        }
+
+        template <typename... From>
+        reference emplace_back(From&&... from)
+        noexcept(std::is_nothrow_constructible<T, From...>::value
+                 && std::is_nothrow_move_assignable<T>::value) {
+            auto& slot = c[next++ & mask];
+            slot = T(std::forward<From>(from)...);
+            return slot;
+        }
+
+        // Copies the values in at most two blocks. Of more than capacity()
+        // values only the last capacity() are copied.
+        template <std::ptrdiff_t N>
+        void append(gsl::span<T const, N> values)
+        noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            auto const count = static_cast<std::uint64_t>(std::size(values));
+            auto const skipped = count > c.size() ? count - c.size() : 0;
+            next += skipped;
+
+            auto first = std::cbegin(values) + skipped;
+            for (auto segment : regions(next, count - skipped)) {
+                std::copy(
+                    first,
+                    first + std::size(segment),
+                    std::begin(segment)
+                );
+                first += std::size(segment);
+            }
+            next += count - skipped;
+        }
+
+        // The elements oldest first as two contiguous runs.
+        std::array<gsl::span<T>, 2> segments()
+        noexcept {
+            return regions(next - n, n);
+        }
+
+        std::array<gsl::span<T const>, 2> segments()
+        const noexcept {
+            auto const s = const_cast<dynamic_ring&>(*this).segments();
+            return {{s[0], s[1]}};
+        }
+
+    private:
+        static size_type round_up(size_type n)
+        noexcept {
+            size_type capacity = 1;
+            while (capacity < n) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        index_type ssize()
+        const noexcept {
+            return static_cast<index_type>(n);
+        }
+
+        size_type position_to_index(size_type position)
+        const noexcept {
+            assert(position < n);
+            return static_cast<size_type>((next - n + position) & mask);
+        }
+
+        // The count elements from the first ever pushed, split where the
+        // storage wraps.
+        std::array<gsl::span<T>, 2> regions(
+            std::uint64_t first,
+            std::uint64_t count
+        ) noexcept {
+            assert(count <= c.size());
+            auto const index = static_cast<size_type>(first & mask);
+            auto const head = std::min<size_type>(count, c.size() - index);
+            return {{
+                gsl::span<T>(c.data() + index, static_cast<index_type>(head)),
+                gsl::span<T>(c.data(), static_cast<index_type>(count - head))
+            }};
+        }
+
+        container_type c;
+        std::uint64_t mask;
+        size_type n;
+        std::uint64_t next;
+    };
+}
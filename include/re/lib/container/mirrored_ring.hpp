@@ -0,0 +1,296 @@
+#pragma once
+
+#include <cassert>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <gsl/span>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define RE_HAS_MIRRORED_MAPPING 1
+#endif
+
+namespace re {
+
+    // Storage for a mirrored_ring: capacity() elements followed by a mirror
+    // of themselves, so that any capacity() elements starting in the first
+    // half can be read contiguously.
+    //
+    // This one keeps the mirror in a second copy of the elements and pays
+    // for it with a second write.
+    template <typename T, std::size_t Size>
+    class duplicated_buffer {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        constexpr size_type capacity()
+        const noexcept {
+            return Size;
+        }
+
+        T const* data()
+        const noexcept {
+            return c.data();
+        }
+
+        // Writes n <= capacity() elements at position, wrapping around.
+        void write(size_type position, T const* first, size_type n)
+        noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            assert(position < Size && n <= Size);
+            auto const head = std::min(n, Size - position);
+            std::copy(first, first + head, c.data() + position);
+            std::copy(first, first + head, c.data() + position + Size);
+            std::copy(first + head, first + n, c.data());
+            std::copy(first + head, first + n, c.data() + Size);
+        }
+
+    private:
+        std::array<T, 2 * Size> c{};
+    };
+
+#ifdef RE_HAS_MIRRORED_MAPPING
+    // The same pages mapped twice back to back in virtual memory. The mirror
+    // is kept by the MMU, so writes are single and reads are contiguous at
+    // no cost. Capacity is Size rounded up to whole pages.
+    template <typename T, std::size_t Size>
+    class mirrored_mapping {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "mapped memory holds trivially copyable elements only");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        mirrored_mapping() :
+            bytes(mapping_size()),
+            p(map(bytes))
+        {
+        }
+
+        mirrored_mapping(mirrored_mapping const& rhs) :
+            mirrored_mapping()
+        {
+            std::copy(rhs.p, rhs.p + rhs.capacity(), p);
+        }
+
+        mirrored_mapping(mirrored_mapping&& rhs)
+        noexcept :
+            bytes(rhs.bytes),
+            p(std::exchange(rhs.p, nullptr))
+        {
+        }
+
+        mirrored_mapping& operator=(mirrored_mapping rhs)
+        noexcept {
+            std::swap(bytes, rhs.bytes);
+            std::swap(p, rhs.p);
+            return *this;
+        }
+
+        ~mirrored_mapping() {
+            if (p != nullptr) {
+                ::munmap(p, 2 * bytes);
+            }
+        }
+
+        size_type capacity()
+        const noexcept {
+            return bytes / sizeof(T);
+        }
+
+        T const* data()
+        const noexcept {
+            return p;
+        }
+
+        void write(size_type position, T const* first, size_type n)
+        noexcept {
+            assert(position < capacity() && n <= capacity());
+            std::copy(first, first + n, p + position);
+        }
+
+    private:
+        // Smallest multiple of the page size that is also a whole number of
+        // elements, so that the mirror starts on an element boundary.
+        static size_type mapping_size() {
+            auto const page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+            auto bytes = (Size * sizeof(T) + page - 1) / page * page;
+            while (bytes % sizeof(T) != 0) {
+                bytes += page;
+            }
+            return bytes;
+        }
+
+        static T* map(size_type bytes) {
+            auto const fd = ::memfd_create("re::mirrored_mapping", MFD_CLOEXEC);
+            if (fd < 0) {
+                throw_system_error();
+            }
+            if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+                ::close(fd);
+                throw_system_error();
+            }
+
+            auto const base = static_cast<char*>(::mmap(
+                nullptr,
+                2 * bytes,
+                PROT_NONE,
+                MAP_PRIVATE | MAP_ANONYMOUS,
+                -1,
+                0
+            ));
+            if (base == MAP_FAILED) {
+                ::close(fd);
+                throw_system_error();
+            }
+
+            for (auto half : {base, base + bytes}) {
+                auto const view = ::mmap(
+                    half,
+                    bytes,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_FIXED,
+                    fd,
+                    0
+                );
+                if (view == MAP_FAILED) {
+                    ::munmap(base, 2 * bytes);
+                    ::close(fd);
+                    throw_system_error();
+                }
+            }
+            ::close(fd);
+            return reinterpret_cast<T*>(base);
+        }
+
+        [[noreturn]] static void throw_system_error() {
+            throw std::system_error(
+                errno,
+                std::generic_category(),
+                "mirrored_mapping"
+            );
+        }
+
+        size_type bytes;
+        T* p;
+    };
+
+    template <typename T, std::size_t Size>
+    using mirrored_storage = std::conditional_t<
+        std::is_trivially_copyable<T>::value,
+        mirrored_mapping<T, Size>,
+        duplicated_buffer<T, Size>
+    >;
+#else
+    template <typename T, std::size_t Size>
+    using mirrored_storage = duplicated_buffer<T, Size>;
+#endif
+
+    // Ring of the last Size values whose every window is a contiguous span,
+    // so it can be handed to span kernels and transforms without the
+    // rotation of ring_array::linearize() or a copy. Starts out filled with
+    // value-initialized elements.
+    template <
+        typename T,
+        std::size_t Size,
+        typename Storage = mirrored_storage<T, Size>
+    >
+    class mirrored_ring {
+        static_assert(Size > 0);
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using const_reference = T const&;
+        using storage_type = Storage;
+
+        constexpr size_type size()
+        const noexcept {
+            return Size;
+        }
+
+        const_reference operator[](size_type position)
+        const noexcept {
+            assert(position < Size);
+            return window()[static_cast<difference_type>(position)];
+        }
+
+        const_reference front()
+        const noexcept {
+            return (*this)[0];
+        }
+
+        const_reference back()
+        const noexcept {
+            return (*this)[Size - 1];
+        }
+
+        void push_back(value_type const& value)
+        noexcept(noexcept(std::declval<Storage&>().write(0, &value, 1))) {
+            storage.write(next, &value, 1);
+            advance(1);
+        }
+
+        // Appends the values in one or two block copies. Only the last
+        // capacity of them can end up in the ring, earlier ones are skipped.
+        template <std::ptrdiff_t N>
+        void append(gsl::span<T const, N> values)
+        noexcept(noexcept(std::declval<Storage&>().write(0, nullptr, 0))) {
+            auto const n = static_cast<size_type>(std::size(values));
+            auto const capacity = storage.capacity();
+            auto const skipped = n > capacity ? n - capacity : 0;
+            advance(skipped);
+            storage.write(next, values.data() + skipped, n - skipped);
+            advance(n - skipped);
+        }
+
+        // The last Size values, oldest first.
+        gsl::span<T const, Size> window()
+        const noexcept {
+            return gsl::span<T const, Size>(start(Size), Size);
+        }
+
+        // The last n <= Size values, oldest first.
+        template <std::ptrdiff_t N>
+        gsl::span<T const, N> last()
+        const noexcept {
+            static_assert(N >= 0 && static_cast<size_type>(N) <= Size);
+            return gsl::span<T const, N>(start(N), N);
+        }
+
+        gsl::span<T const> last(size_type n)
+        const noexcept {
+            assert(n <= Size);
+            return gsl::span<T const>(
+                start(n),
+                static_cast<difference_type>(n)
+            );
+        }
+
+    private:
+        T const* start(size_type n)
+        const noexcept {
+            auto const capacity = storage.capacity();
+            auto const first = next >= n ? next - n : next + capacity - n;
+            return storage.data() + first;
+        }
+
+        void advance(size_type n)
+        noexcept {
+            next = (next + n) % storage.capacity();
+        }
+
+        Storage storage;
+        size_type next = 0;
+    };
+}
@@ -1,11 +1,24 @@
 #pragma once
 
+#include <cassert>
+
 #include <algorithm>
+#include <array>
+#include <iterator>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 
+#include <gsl/span>
+
+#include "indexed_iterator.hpp"
+
 namespace re
 {
+// Fixed-length history over a random access container, C's oldest element
+// first. Rather than rotating the container, it keeps the offset of the
+// logical front in it, so pushing at either end is O(1) and inserting in
+// the middle moves only the shorter side.
 template <typename C>
 class revolver
 {
@@ -19,10 +32,10 @@ public:
     using difference_type = typename C::difference_type;
     using index_type = difference_type;
 
-    using iterator = typename C::iterator;
-    using const_iterator = typename C::const_iterator;
-    using reverse_iterator = typename C::reverse_iterator;
-    using const_reverse_iterator = typename C::const_reverse_iterator;
+    using iterator = indexed_iterator<revolver, false>;
+    using const_iterator = indexed_iterator<revolver, true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
     revolver()
     noexcept(std::is_nothrow_default_constructible<C>::value)
@@ -31,13 +44,15 @@ public:
 
     revolver(revolver const& ring)
     noexcept(std::is_nothrow_copy_constructible<C>::value) :
-        c(ring.c)
+        c(ring.c),
+        head(ring.head)
     {
     }
 
     revolver(revolver&& ring)
     noexcept(std::is_nothrow_move_constructible<C>::value) :
-        c(std::move(ring.c))
+        c(std::move(ring.c)),
+        head(std::exchange(ring.head, 0))
     {
     }
 
@@ -56,24 +71,28 @@ public:
     revolver& operator=(revolver const& rhs)
     noexcept(std::is_nothrow_copy_assignable<C>::value) {
         c = rhs.c;
+        head = rhs.head;
         return *this;
     }
 
     revolver& operator=(revolver&& rhs)
     noexcept(std::is_nothrow_move_assignable<C>::value) {
         c = std::move(rhs.c);
+        head = std::exchange(rhs.head, 0);
         return *this;
     }
 
     revolver& operator=(C const& rhs)
     noexcept(std::is_nothrow_copy_assignable<C>::value) {
         c = rhs;
+        head = 0;
         return *this;
     }
 
     revolver& operator=(C&& rhs)
     noexcept(std::is_nothrow_move_assignable<C>::value) {
         c = std::move(rhs);
+        head = 0;
         return *this;
     }
 
@@ -83,50 +102,90 @@ public:
     > revolver& operator=(T&& t)
     noexcept(std::is_nothrow_assignable<C, T>::value) {
         c = std::forward<T>(t);
+        head = 0;
         return *this;
     }
 
     void swap(revolver& rhs)
     noexcept(std::is_nothrow_swappable<C>::value) {
         c.swap(rhs.c);
+        std::swap(head, rhs.head);
     }
 
     void swap(C& rhs)
     noexcept(std::is_nothrow_swappable<C>::value) {
+        linearize();
         c.swap(rhs);
     }
 
+    // Rotates the container into logical order and returns it.
+    C& linearize()
+    noexcept(std::is_nothrow_swappable<value_type>::value) {
+        std::rotate(std::begin(c), std::begin(c) + head, std::end(c));
+        head = 0;
+        return c;
+    }
+
     size_type size() const noexcept { return c.size(); }
     size_type max_size() const noexcept { return size(); }
     bool empty() const noexcept { return c.empty(); }
-    pointer data() const noexcept { return c.data();  }
+    pointer data() noexcept { return linearize().data(); }
 
     void fill(const_reference value)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value) {
         std::fill(begin(), end(), value);
     }
 
-    reference operator[](index_type i) { return c[i]; }
-    const_reference operator[](index_type i) const noexcept { return c[i]; }
-    reference at(index_type i) { return c.at(i); }
-    const_reference at(index_type i) const { return c.at(i); }
-    reference front() noexcept { return c.front(); }
-    const_reference front() const noexcept { return c.front(); }
-    reference back() noexcept { return c.back(); }
-    const_reference back() const noexcept { return c.back(); }
-
-    iterator begin() noexcept { return c.begin(); }
-    iterator end() noexcept { return c.end(); }
-    const_iterator begin() const noexcept { return c.begin(); }
-    const_iterator end() const noexcept { return c.end(); }
-    const_iterator cbegin() const noexcept { return c.cbegin(); }
-    const_iterator cend() const noexcept { return c.cend(); }
-    reverse_iterator rbegin() noexcept { return c.rbegin(); }
-    reverse_iterator rend() noexcept { return c.rend(); }
-    const_reverse_iterator rbegin() const noexcept { return c.rbegin(); }
-    const_reverse_iterator rend() const noexcept { return c.rend(); }
-    const_reverse_iterator crbegin() const noexcept { return c.crbegin(); }
-    const_reverse_iterator crend() const noexcept { return c.crend(); }
+    reference operator[](index_type i) { return c[physical(i)]; }
+    const_reference operator[](index_type i) const noexcept {
+        return c[physical(i)];
+    }
+    reference at(index_type i) { return c.at(physical(checked(i))); }
+    const_reference at(index_type i) const {
+        return c.at(physical(checked(i)));
+    }
+    reference front() noexcept { return (*this)[0]; }
+    const_reference front() const noexcept { return (*this)[0]; }
+    reference back() noexcept { return (*this)[last()]; }
+    const_reference back() const noexcept { return (*this)[last()]; }
+
+    iterator begin() noexcept { return iterator(this, 0); }
+    iterator end() noexcept { return iterator(this, ssize()); }
+    const_iterator begin() const noexcept { return cbegin(); }
+    const_iterator end() const noexcept { return cend(); }
+    const_iterator cbegin() const noexcept { return const_iterator(this, 0); }
+    const_iterator cend() const noexcept {
+        return const_iterator(this, ssize());
+    }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return crbegin(); }
+    const_reverse_iterator rend() const noexcept { return crend(); }
+    const_reverse_iterator crbegin() const noexcept {
+        return const_reverse_iterator(cend());
+    }
+    const_reverse_iterator crend() const noexcept {
+        return const_reverse_iterator(cbegin());
+    }
+
+    // The elements oldest first as two contiguous runs of the container.
+    std::array<gsl::span<value_type>, 2> segments()
+    noexcept {
+        auto const first = c.data() + head;
+        return {{
+            gsl::span<value_type>(first, ssize() - head),
+            gsl::span<value_type>(c.data(), head)
+        }};
+    }
+
+    std::array<gsl::span<value_type const>, 2> segments()
+    const noexcept {
+        auto const first = c.data() + head;
+        return {{
+            gsl::span<value_type const>(first, ssize() - head),
+            gsl::span<value_type const>(c.data(), head)
+        }};
+    }
 
     void push_back(const_reference value)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value) {
@@ -144,8 +203,9 @@ public:
     noexcept(std::is_nothrow_constructible<value_type, From...>::value
              && std::is_nothrow_move_assignable<value_type>::value)
     {
+        assert(!empty());
         front() = value_type(std::forward<From>(from)...);
-        std::rotate(begin(), begin() + 1, end());
+        head = wrap(head + 1);
         return back();
     }
 
@@ -164,27 +224,42 @@ public:
     reference emplace_front(From&&... from)
     noexcept(std::is_nothrow_constructible<value_type, From...>::value
              && std::is_nothrow_move_assignable<value_type>::value) {
-        back() = value_type(std::forward<From>(from)...);
-        std::rotate(begin(), end() - 1, end());
+        assert(!empty());
+        head = wrap(head + ssize() - 1);
+        front() = value_type(std::forward<From>(from)...);
         return front();
     }
 
+    // Each of the n copies drops the oldest element, at most as many as
+    // there are before pos, and the copies end up right before pos.
     void insert(const_iterator pos, size_type n, value_type value)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value
              && std::is_nothrow_move_assignable<value_type>::value) {
-        difference_type d = std::distance(cbegin(), pos);
-        d = std::min(d, static_cast<difference_type>(n));
-        while (d --> 0) {
-            insert(pos, value);
-        }
+        auto const d = std::distance(cbegin(), pos);
+        auto const m = std::min(d, static_cast<difference_type>(n));
+        open_before(d, m);
+        std::fill(begin() + (d - m), begin() + d, value);
     }
 
-    template <typename InputIt>
+    // Same as inserting the values one by one at pos: the last of them
+    // that fit end up right before pos, in order.
+    template <
+        typename InputIt,
+        typename = typename std::iterator_traits<InputIt>::iterator_category
+    >
     void insert(const_iterator pos, InputIt first, InputIt last)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value
              && std::is_nothrow_move_assignable<value_type>::value) {
-        while (first != last) {
-            insert(pos, *(first++));
+        if constexpr (is_forward_iterator<InputIt>::value) {
+            auto const d = std::distance(cbegin(), pos);
+            auto const k = std::distance(first, last);
+            auto const m = std::min(d, k);
+            open_before(d, m);
+            std::copy(std::next(first, k - m), last, begin() + (d - m));
+        } else {
+            while (first != last) {
+                insert(pos, *(first++));
+            }
         }
     }
 
@@ -200,22 +275,42 @@ public:
         return emplace(pos, std::move(value));
     }
 
+    // Each of the n copies drops the newest element, at most as many as
+    // there are from pos on, and the copies end up at pos.
     void rinsert(const_iterator pos, size_type n, value_type value)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value
              && std::is_nothrow_move_assignable<value_type>::value) {
-        difference_type d = std::distance(pos, cend());
-        d = std::min(d, static_cast<difference_type>(n));
-        while (d --> 0) {
-            rinsert(pos, value);
-        }
+        auto const d = std::distance(pos, cend());
+        auto const m = std::min(d, static_cast<difference_type>(n));
+        auto const p = ssize() - d;
+        open_after(p, m);
+        std::fill(begin() + p, begin() + (p + m), value);
     }
 
-    template <typename InputIt>
+    // Same as inserting the values one by one at pos: the last of them
+    // that fit end up at pos, in reverse order.
+    template <
+        typename InputIt,
+        typename = typename std::iterator_traits<InputIt>::iterator_category
+    >
     void rinsert(const_iterator pos, InputIt first, InputIt last)
     noexcept(std::is_nothrow_copy_constructible<value_type>::value
              && std::is_nothrow_move_assignable<value_type>::value) {
-        while (first != last) {
-            rinsert(pos, *(first++));
+        if constexpr (is_forward_iterator<InputIt>::value) {
+            auto const d = std::distance(pos, cend());
+            auto const k = std::distance(first, last);
+            auto const m = std::min(d, k);
+            auto const p = ssize() - d;
+            open_after(p, m);
+            std::reverse_copy(
+                std::next(first, k - m),
+                last,
+                begin() + p
+            );
+        } else {
+            while (first != last) {
+                rinsert(pos, *(first++));
+            }
         }
     }
 
@@ -231,44 +326,144 @@ public:
         return remplace(pos, std::move(value));
     }
 
+    // Drops the oldest element and puts the new one right before pos.
     template <typename... From>
     iterator emplace(const_iterator pos, From&&... from)
     noexcept(std::is_nothrow_constructible<value_type, From...>::value
              && std::is_nothrow_move_assignable<value_type>::value)
     {
-        auto d = std::distance(cbegin(), pos);
+        auto const d = std::distance(cbegin(), pos);
         if (d == 0) {
             return begin();
         }
 
-        front() = value_type(std::forward<From>(from)...);
-        if (d == 1) {
-            return begin();
-        }
-        auto last = begin() + d;
-        std::rotate(begin(), begin() + 1, last);
-        return last;
+        open_before(d, 1);
+        (*this)[d - 1] = value_type(std::forward<From>(from)...);
+        return d == 1 ? begin() : begin() + d;
     }
 
+    // Drops the newest element and puts the new one at pos.
     template <typename... From>
     iterator remplace(const_iterator pos, From&&... from)
     noexcept(std::is_nothrow_constructible<value_type, From...>::value
              && std::is_nothrow_move_assignable<value_type>::value)
     {
-        auto d = std::distance(pos, end());
+        auto const d = std::distance(pos, cend());
         if (d == 0) {
             return end();
         }
-        back() = value_type(std::forward<From>(from)...);
-        if (d == 1) {
-            return end() - 1;
-        }
-        auto first = end() - d;
-        std::rotate(first, end() - 1, end()) - 1;
-        return first;
+
+        auto const p = ssize() - d;
+        open_after(p, 1);
+        (*this)[p] = value_type(std::forward<From>(from)...);
+        return begin() + p;
     }
 
 private:
+    template <typename It>
+    using is_forward_iterator = std::is_base_of<
+        std::forward_iterator_tag,
+        typename std::iterator_traits<It>::iterator_category
+    >;
+
+    index_type ssize()
+    const noexcept {
+        return static_cast<index_type>(c.size());
+    }
+
+    index_type last()
+    const noexcept {
+        return ssize() - 1;
+    }
+
+    // Index into c of i in [0, 2 * size()).
+    index_type wrap(index_type i)
+    const noexcept {
+        return (i < ssize()) ? i : (i - ssize());
+    }
+
+    size_type physical(index_type i)
+    const noexcept {
+        assert(i >= 0 && i < ssize());
+        return static_cast<size_type>(wrap(head + i));
+    }
+
+    index_type checked(index_type i)
+    const {
+        if (i < 0 || i >= ssize()) {
+            throw std::out_of_range("revolver");
+        }
+        return i;
+    }
+
+    // Makes [d - m, d) free by dropping the m oldest elements and moving
+    // either the elements before d to the front or the elements from d on
+    // to the back, whichever are fewer.
+    void open_before(index_type d, index_type m)
+    noexcept(std::is_nothrow_move_assignable<value_type>::value) {
+        assert(m >= 0 && m <= d && d <= ssize());
+        if (d - m <= ssize() - d) {
+            move_left(m, 0, d - m);
+        } else {
+            head = wrap(head + m);
+            move_right(d - m, d, ssize() - d);
+        }
+    }
+
+    // Makes [p, p + m) free by dropping the m newest elements, moving the
+    // fewer of the elements before p and from p on.
+    void open_after(index_type p, index_type m)
+    noexcept(std::is_nothrow_move_assignable<value_type>::value) {
+        assert(m >= 0 && p >= 0 && p + m <= ssize());
+        if (ssize() - m - p <= p) {
+            move_right(p, p + m, ssize() - m - p);
+        } else {
+            head = wrap(head + ssize() - m);
+            move_left(m, 0, p);
+        }
+    }
+
+    // Moves n elements from logical position from to the lower position
+    // to, in runs that are contiguous in the container at both ends.
+    void move_left(index_type from, index_type to, index_type n)
+    noexcept(std::is_nothrow_move_assignable<value_type>::value) {
+        assert(to <= from);
+        auto const first = std::begin(c);
+        while (n > 0) {
+            auto const source = static_cast<index_type>(physical(from));
+            auto const target = static_cast<index_type>(physical(to));
+            auto const run = std::min({n, ssize() - source, ssize() - target});
+            std::move(first + source, first + source + run, first + target);
+            from += run;
+            to += run;
+            n -= run;
+        }
+    }
+
+    // Moves n elements from logical position from to the higher position
+    // to, last ones first.
+    void move_right(index_type from, index_type to, index_type n)
+    noexcept(std::is_nothrow_move_assignable<value_type>::value) {
+        assert(to >= from);
+        auto const first = std::begin(c);
+        while (n > 0) {
+            auto const source = 1 + static_cast<index_type>(
+                physical(from + n - 1)
+            );
+            auto const target = 1 + static_cast<index_type>(
+                physical(to + n - 1)
+            );
+            auto const run = std::min({n, source, target});
+            std::move_backward(
+                first + (source - run),
+                first + source,
+                first + target
+            );
+            n -= run;
+        }
+    }
+
     C c;
+    index_type head = 0;
 };
 }
@@ -228,9 +228,48 @@ namespace re {
             }
         }
 
+        // Copies the data in at most two blocks. Of more than Size values
+        // only the last Size are kept.
         template <std::ptrdiff_t N>
-        constexpr void append(gsl::span<T const, N> data) {
-            append(std::cbegin(data), std::cend(data));
+        constexpr void append(gsl::span<T const, N> data)
+        noexcept(std::is_nothrow_copy_assignable<T>::value) {
+            auto first = std::cbegin(data);
+            auto n = static_cast<size_type>(std::size(data));
+            if (n >= Size) {
+                std::copy(first + (n - Size), std::cend(data), std::begin(c));
+                next = std::begin(c);
+                return;
+            }
+
+            auto const head = std::min(
+                n,
+                static_cast<size_type>(std::end(c) - next)
+            );
+            next = std::copy(first, first + head, next);
+            if (next == std::end(c)) {
+                next = std::copy(first + head, std::cend(data), std::begin(c));
+            }
+        }
+
+        // The elements oldest first as two contiguous runs, the second of
+        // which is empty when the ring happens to be linear. Algorithms run
+        // over each run at the speed of a plain array.
+        constexpr std::array<gsl::span<T>, 2> segments()
+        noexcept {
+            auto const d = next - std::cbegin(c);
+            return {{
+                gsl::span<T>(c.data() + d, difference_type{Size} - d),
+                gsl::span<T>(c.data(), d)
+            }};
+        }
+
+        constexpr std::array<gsl::span<T const>, 2> segments()
+        const noexcept {
+            auto const d = next - std::cbegin(c);
+            return {{
+                gsl::span<T const>(c.data() + d, difference_type{Size} - d),
+                gsl::span<T const>(c.data(), d)
+            }};
         }
 
     private:
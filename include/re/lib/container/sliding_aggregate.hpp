@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cassert>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "dynamic_ring.hpp"
+
+namespace re {
+
+    // Values pushed into a window of the last n together with their
+    // position, kept in Compare order from the front so that the front is
+    // the extremum of the window. Every value enters and leaves once, so a
+    // push costs O(1) amortized. The caller expires the oldest position
+    // before pushing past n, which keeps at most n entries.
+    template <typename T, typename Compare>
+    class monotonic_queue {
+    public:
+        explicit monotonic_queue(std::size_t n) :
+            c(round_up(n)),
+            mask(c.size() - 1)
+        {
+        }
+
+        void push(std::uint64_t position, T value)
+        noexcept {
+            while (tail != head
+                   && !compare(c[(tail - 1) & mask].value, value)) {
+                --tail;
+            }
+            c[tail++ & mask] = {position, value};
+        }
+
+        // Drops the front if it is older than position.
+        void expire(std::uint64_t position)
+        noexcept {
+            if (tail != head && c[head & mask].position < position) {
+                ++head;
+            }
+        }
+
+        T front()
+        const noexcept {
+            assert(tail != head);
+            return c[head & mask].value;
+        }
+
+    private:
+        struct entry {
+            std::uint64_t position;
+            T value;
+        };
+
+        static std::size_t round_up(std::size_t n)
+        noexcept {
+            std::size_t capacity = 1;
+            while (capacity < n) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        std::vector<entry> c;
+        std::uint64_t mask;
+        std::uint64_t head = 0;
+        std::uint64_t tail = 0;
+        Compare compare;
+    };
+
+    // Sum, mean, variance, minimum and maximum of the last length() values
+    // pushed, each updated in O(1) amortized per push however long the
+    // window is. Until length() values have been pushed the statistics are
+    // of those pushed so far.
+    //
+    // The sum is compensated (Neumaier) so that adding and removing values
+    // for hours does not drift, and the variance is updated by Welford's
+    // method for a window in which one value replaces another.
+    template <typename T>
+    class sliding_aggregate {
+        static_assert(std::is_floating_point<T>::value);
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        explicit sliding_aggregate(size_type length) :
+            history(length),
+            lowest(length),
+            highest(length)
+        {
+            assert(length > 0);
+        }
+
+        size_type length()
+        const noexcept {
+            return history.size();
+        }
+
+        // Values in the window so far.
+        size_type size()
+        const noexcept {
+            return static_cast<size_type>(
+                std::min<std::uint64_t>(pushed, history.size())
+            );
+        }
+
+        bool empty()
+        const noexcept {
+            return pushed == 0;
+        }
+
+        void push_back(value_type value)
+        noexcept {
+            auto const full = pushed >= history.size();
+            auto const oldest = history.front();
+            history.push_back(value);
+            if (full) {
+                lowest.expire(pushed + 1 - history.size());
+                highest.expire(pushed + 1 - history.size());
+            }
+            lowest.push(pushed, value);
+            highest.push(pushed, value);
+            ++pushed;
+
+            if (full) {
+                add(-oldest);
+                add(value);
+
+                auto const n = static_cast<T>(history.size());
+                auto const previous = average;
+                average += (value - oldest) / n;
+                m2 += (value - oldest) * (value - average + oldest - previous);
+                m2 = std::max(m2, T{0});
+            } else {
+                add(value);
+
+                auto const n = static_cast<T>(pushed);
+                auto const delta = value - average;
+                average += delta / n;
+                m2 += delta * (value - average);
+            }
+        }
+
+        // The most recent value.
+        value_type back()
+        const noexcept {
+            assert(!empty());
+            return history.back();
+        }
+
+        value_type sum()
+        const noexcept {
+            return total + compensation;
+        }
+
+        value_type mean()
+        const noexcept {
+            assert(!empty());
+            return sum() / static_cast<T>(size());
+        }
+
+        // Population variance of the window.
+        value_type variance()
+        const noexcept {
+            assert(!empty());
+            return m2 / static_cast<T>(size());
+        }
+
+        value_type min()
+        const noexcept {
+            return lowest.front();
+        }
+
+        value_type max()
+        const noexcept {
+            return highest.front();
+        }
+
+    private:
+        void add(value_type value)
+        noexcept {
+            auto const t = total + value;
+            if (std::abs(total) >= std::abs(value)) {
+                compensation += (total - t) + value;
+            } else {
+                compensation += (value - t) + total;
+            }
+            total = t;
+        }
+
+        dynamic_ring<T> history;
+        monotonic_queue<T, std::less<T>> lowest;
+        monotonic_queue<T, std::greater<T>> highest;
+        std::uint64_t pushed = 0;
+        T total = 0;
+        T compensation = 0;
+        T average = 0;
+        T m2 = 0;
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace re {
+
+    // Position in a sorted window of the given length of the value at
+    // fraction q, 0 for the minimum, 0.5 for the median, 1 for the maximum.
+    inline std::size_t percentile_rank(std::size_t length, double q)
+    noexcept {
+        assert(length > 0 && q >= 0 && q <= 1);
+        return static_cast<std::size_t>(std::lround(q * (length - 1)));
+    }
+
+    // The value of a fixed rank among the last length() values, kept in two
+    // heaps: the rank + 1 smallest values in a max-heap and the rest in a
+    // min-heap, so the top of the first is the answer. Each value tracks
+    // its place in the heaps, so the oldest can be replaced in place and
+    // a push costs O(log length()).
+    //
+    // Starts out filled with copies of a value, which keeps both heaps at
+    // the same size for good.
+    template <typename T>
+    class sliding_percentile {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+
+        sliding_percentile(
+            size_type length,
+            size_type rank,
+            value_type const& value = value_type()
+        ) :
+            values(length, value),
+            places(length),
+            lower(rank + 1),
+            upper(length - rank - 1)
+        {
+            assert(rank < length);
+            for (size_type slot = 0; slot < length; ++slot) {
+                auto& heap = slot <= rank ? lower : upper;
+                auto const index = slot <= rank ? slot : slot - rank - 1;
+                heap[index] = slot;
+                places[slot] = {slot > rank, index};
+            }
+        }
+
+        size_type length()
+        const noexcept {
+            return values.size();
+        }
+
+        size_type rank()
+        const noexcept {
+            return lower.size() - 1;
+        }
+
+        // Replaces the oldest value.
+        void push_back(value_type value)
+        noexcept {
+            auto const slot = oldest;
+            oldest = oldest + 1 == values.size() ? 0 : oldest + 1;
+            values[slot] = value;
+
+            auto const place = places[slot];
+            if (place.upper) {
+                sift(upper, place.index, std::less<T>());
+            } else {
+                sift(lower, place.index, std::greater<T>());
+            }
+
+            if (!upper.empty() && values[lower[0]] > values[upper[0]]) {
+                std::swap(lower[0], upper[0]);
+                places[lower[0]] = {false, 0};
+                places[upper[0]] = {true, 0};
+                sift(lower, 0, std::greater<T>());
+                sift(upper, 0, std::less<T>());
+            }
+        }
+
+        value_type value()
+        const noexcept {
+            return values[lower[0]];
+        }
+
+    private:
+        struct place {
+            bool upper;
+            size_type index;
+        };
+
+        // Restores the heap order around index, whose value has changed.
+        template <typename Before>
+        void sift(std::vector<size_type>& heap, size_type index, Before before)
+        noexcept {
+            auto const upper_heap = &heap == &upper;
+            auto const move = [&] (size_type from, size_type to) {
+                std::swap(heap[from], heap[to]);
+                places[heap[from]] = {upper_heap, from};
+                places[heap[to]] = {upper_heap, to};
+            };
+
+            while (index > 0) {
+                auto const parent = (index - 1) / 2;
+                if (!before(values[heap[index]], values[heap[parent]])) {
+                    break;
+                }
+                move(index, parent);
+                index = parent;
+            }
+
+            auto const n = heap.size();
+            for (auto child = 2 * index + 1; child < n; child = 2 * index + 1) {
+                if (child + 1 < n
+                    && before(values[heap[child + 1]], values[heap[child]])) {
+                    ++child;
+                }
+                if (!before(values[heap[child]], values[heap[index]])) {
+                    break;
+                }
+                move(index, child);
+                index = child;
+            }
+        }
+
+        std::vector<T> values;
+        std::vector<place> places;
+        std::vector<size_type> lower;
+        std::vector<size_type> upper;
+        size_type oldest = 0;
+    };
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cassert>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+
+namespace re {
+
+    // The n elements of a ring of Size elements at data that follow the
+    // first ever written, split where the storage wraps.
+    template <typename U, std::size_t Size, typename T>
+    std::array<gsl::span<U>, 2> wrapped_regions(
+        T* data,
+        std::size_t first,
+        std::size_t n
+    ) noexcept {
+        assert(n <= Size);
+        auto const index = first % Size;
+        auto const head = std::min(n, Size - index);
+        return {{
+            gsl::span<U>(data + index, static_cast<std::ptrdiff_t>(head)),
+            gsl::span<U>(data, static_cast<std::ptrdiff_t>(n - head))
+        }};
+    }
+
+    // Wait-free ring for handing samples from one producer thread to one
+    // consumer thread, such as from an audio callback to an analysis loop.
+    //
+    // Both sides count the elements they have ever written or read. The
+    // counts only grow, so the ring holds written - read elements and
+    // neither side has to tell a full ring from an empty one. Each count
+    // is published by its owner only, on a cache line of its own, next to
+    // the owner's cached copy of the other count which saves it reloading
+    // the contended line on every call.
+    template <typename T, std::size_t Size>
+    class spsc_ring {
+        static_assert(Size > 0);
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "elements are handed over by plain copies");
+
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr size_type capacity()
+        const noexcept {
+            return Size;
+        }
+
+        // Producer side.
+
+        size_type writable()
+        noexcept {
+            producer.other = consumer.count.load(std::memory_order_acquire);
+            return Size - (producer.count.load(std::memory_order_relaxed)
+                           - producer.other);
+        }
+
+        // Free space as two contiguous runs, to be filled in place and then
+        // handed over by commit().
+        std::array<gsl::span<T>, 2> prepare()
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            return regions<T>(written, writable());
+        }
+
+        void commit(size_type n)
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            assert(n <= Size - (written - producer.other));
+            producer.count.store(written + n, std::memory_order_release);
+        }
+
+        // Copies as many values as fit and returns how many did.
+        size_type write(gsl::span<T const> values)
+        noexcept {
+            auto const written = producer.count.load(std::memory_order_relaxed);
+            auto space = Size - (written - producer.other);
+            if (space < static_cast<size_type>(std::size(values))) {
+                space = writable();
+            }
+
+            auto const n = std::min(
+                space,
+                static_cast<size_type>(std::size(values))
+            );
+            auto first = values.data();
+            for (auto region : regions<T>(written, n)) {
+                first = copy(first, region);
+            }
+            producer.count.store(written + n, std::memory_order_release);
+            return n;
+        }
+
+        // Consumer side.
+
+        size_type readable()
+        noexcept {
+            consumer.other = producer.count.load(std::memory_order_acquire);
+            return consumer.other - consumer.count.load(std::memory_order_relaxed);
+        }
+
+        // Readable values oldest first as two contiguous runs, valid until
+        // they are released by consume().
+        std::array<gsl::span<T const>, 2> peek()
+        noexcept {
+            auto const read = consumer.count.load(std::memory_order_relaxed);
+            return regions<T const>(read, readable());
+        }
+
+        void consume(size_type n)
+        noexcept {
+            auto const read = consumer.count.load(std::memory_order_relaxed);
+            assert(n <= consumer.other - read);
+            consumer.count.store(read + n, std::memory_order_release);
+        }
+
+        // Copies as many values as are readable into out and returns how
+        // many were.
+        size_type read(gsl::span<T> out)
+        noexcept {
+            auto const read = consumer.count.load(std::memory_order_relaxed);
+            auto available = consumer.other - read;
+            if (available < static_cast<size_type>(std::size(out))) {
+                available = readable();
+            }
+
+            auto const n = std::min(
+                available,
+                static_cast<size_type>(std::size(out))
+            );
+            auto first = out.data();
+            for (auto region : regions<T const>(read, n)) {
+                first = std::copy(std::cbegin(region), std::cend(region), first);
+            }
+            consumer.count.store(read + n, std::memory_order_release);
+            return n;
+        }
+
+    private:
+        template <typename U>
+        std::array<gsl::span<U>, 2> regions(size_type first, size_type n)
+        noexcept {
+            return wrapped_regions<U, Size>(c.data(), first, n);
+        }
+
+        static T const* copy(T const* first, gsl::span<T> region)
+        noexcept {
+            std::copy(first, first + std::size(region), std::begin(region));
+            return first + std::size(region);
+        }
+
+        struct alignas(cache_line_size) side {
+            std::atomic<size_type> count{0};
+            size_type other = 0;
+        };
+
+        side producer;
+        side consumer;
+        std::array<T, Size> c{};
+    };
+}
@@ -11,6 +11,7 @@
 #include <gsl/span>
 
 #include <re/lib/fft/real_fft.hpp>
+#include <re/lib/simd/aligned.hpp>
 
 namespace re {
 namespace fft {
@@ -30,7 +31,7 @@ public:
     void
     operator()(gsl::span<T const, N> input, gsl::span<T, N> output)
     noexcept {
-        std::array<T, 2*N> time_domain;
+        simd::aligned_array<T, 2*N> time_domain;
         std::copy(
             std::cbegin(input),
             std::cend(input),
@@ -42,7 +43,7 @@ public:
             0
         );
 
-        std::array<std::complex<T>, N + 1> frequency_domain;
+        simd::aligned_array<std::complex<T>, N + 1> frequency_domain;
         fft(time_domain, frequency_domain);
 
         std::transform(
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cmath>
 #include <complex>
 #include <tuple>
 #include <utility>
 
+#include <re/lib/simd/identification.hpp>
+
 namespace re {
 namespace fft {
 
@@ -31,10 +34,17 @@ template <typename T>
 std::complex<T>
 inline multiply_fast(std::complex<T> a, std::complex<T> b) noexcept
 {
+#ifdef RE_ARCH_FMA
+    return {
+        std::fma(a.real(), b.real(), -(a.imag() * b.imag())),
+        std::fma(a.real(), b.imag(), a.imag() * b.real())
+    };
+#else
     return {
         a.real() * b.real() - a.imag() * b.imag(),
         a.real() * b.imag() + a.imag() * b.real()
     };
+#endif
 }
 
 template <bool IsInverse, typename T>
@@ -12,6 +12,7 @@
 #include <re/lib/common.hpp>
 #include <re/lib/container/subspan.hpp>
 #include <re/lib/fft/common.hpp>
+#include <re/lib/simd/aligned.hpp>
 
 namespace re {
 namespace fft {
@@ -59,6 +60,19 @@ private:
         return n_out / radix(n_out);
     }
 
+    // Butterflies expect their sub-transforms in digit-reversed order.
+    static constexpr int_t block(int_t k, int_t n_out)
+    {
+        switch (radix(n_out)) {
+            case 8:
+                return ((k & 1) << 2) | (k & 2) | (k >> 2);
+            case 4:
+                return ((k & 1) << 1) | (k >> 1);
+            default:
+                return k;
+        }
+    }
+
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "InfiniteRecursion"
 
@@ -71,19 +85,19 @@ private:
         constexpr auto s = stride(N_out);
         constexpr auto m_in = N_in - s;
 
-        step_in(subspan<0*s, m_in>(in), subspan<0*m_out, m_out>(out));
-        step_in(subspan<1*s, m_in>(in), subspan<1*m_out, m_out>(out));
+        step_in(subspan<block(0, N_out)*s, m_in>(in), subspan<0*m_out, m_out>(out));
+        step_in(subspan<block(1, N_out)*s, m_in>(in), subspan<1*m_out, m_out>(out));
 
         if (radix(N_out) > 2) {
-            step_in(subspan<2*s, m_in>(in), subspan<2*m_out, m_out>(out));
-            step_in(subspan<3*s, m_in>(in), subspan<3*m_out, m_out>(out));
+            step_in(subspan<block(2, N_out)*s, m_in>(in), subspan<2*m_out, m_out>(out));
+            step_in(subspan<block(3, N_out)*s, m_in>(in), subspan<3*m_out, m_out>(out));
         }
 
         if (radix(N_out) > 4) {
-            step_in(subspan<4*s, m_in>(in), subspan<4*m_out, m_out>(out));
-            step_in(subspan<5*s, m_in>(in), subspan<5*m_out, m_out>(out));
-            step_in(subspan<6*s, m_in>(in), subspan<6*m_out, m_out>(out));
-            step_in(subspan<7*s, m_in>(in), subspan<7*m_out, m_out>(out));
+            step_in(subspan<block(4, N_out)*s, m_in>(in), subspan<4*m_out, m_out>(out));
+            step_in(subspan<block(5, N_out)*s, m_in>(in), subspan<5*m_out, m_out>(out));
+            step_in(subspan<block(6, N_out)*s, m_in>(in), subspan<6*m_out, m_out>(out));
+            step_in(subspan<block(7, N_out)*s, m_in>(in), subspan<7*m_out, m_out>(out));
         }
 
         butterfly(out);
@@ -195,7 +209,7 @@ private:
         constexpr auto m = remainder(N_out);
         constexpr auto s = stride(N_out);
 
-        for (auto i = 1; i < m; ++i) {
+        for (auto i = 0; i < m; ++i) {
             if (i > 0) {
                 out[i + 1*m] = multiply_fast(out[i + 1*m], twiddles[4*i*s]);
                 out[i + 2*m] = multiply_fast(out[i + 2*m], twiddles[2*i*s]);
@@ -212,8 +226,8 @@ private:
             scissors(out[i + 6*m], out[i + 7*m]);
 
             out[i + 3*m] = flip<Direction>(out[i + 3*m]);
-            out[i + 5*m] = multiply_fast(out[i + 5*m], twiddles[m]);
-            out[i + 7*m] = multiply_fast(out[i + 7*m], twiddles[m]);
+            out[i + 5*m] = multiply_fast(out[i + 5*m], twiddles[N/8]);
+            out[i + 7*m] = multiply_fast(out[i + 7*m], twiddles[N/8]);
             out[i + 7*m] = flip<Direction>(out[i + 7*m]);
 
             scissors(out[i + 0*m], out[i + 2*m]);
@@ -231,7 +245,7 @@ private:
         }
     }
 
-    std::array<cpx_t, N/2> twiddles;
+    simd::aligned_array<cpx_t, N> twiddles;
 };
 
 } // fft
@@ -14,6 +14,7 @@
 #include <gsl/span>
 
 #include <re/lib/common.hpp>
+#include <re/lib/simd/aligned.hpp>
 
 namespace re {
 namespace fft {
@@ -80,7 +81,7 @@ private:
         return (1 - std::cos(relative_position * 2 * pi<T>)) / 2;
     }
 
-    std::array<T, N> cache;
+    simd::aligned_array<T, N> cache;
 };
 
 } // fft
@@ -11,6 +11,7 @@
 
 #include <re/lib/common.hpp>
 #include <re/lib/fft/fft.hpp>
+#include <re/lib/simd/aligned.hpp>
 
 namespace re {
 namespace fft {
@@ -26,7 +27,7 @@ class real_fft
 public:
     real_fft() noexcept
     {
-        auto const step = (is_inverse(Direction) ? -2 : 2) * pi<real_t> / N;
+        auto const step = (is_inverse(Direction) ? 2 : -2) * pi<real_t> / N;
         for (auto i = 0u; i < std::size(twiddles); ++i) {
             twiddles[i] = std::polar(real_t{1}, (i + N / 4) * step);
         }
@@ -108,13 +109,13 @@ private:
             }
         }
         data[N/4] = std::conj(data[N/4]);
-        if (is_forward(Direction)) {
-            data[N/4] = 0.5f * data[N/4];
+        if (is_inverse(Direction)) {
+            data[N/4] = 2.f * data[N/4];
         }
     }
 
     fft<real_t, N/2, Direction> fft_;
-    std::array<cpx_t, N/2> twiddles;
+    simd::aligned_array<cpx_t, N/2> twiddles;
 };
 
 } // fft
@@ -4,6 +4,7 @@
 #include <re/lib/common.hpp>
 #include <re/lib/container/subspan.hpp>
 
+#include <re/lib/simd/aligned.hpp>
 #include <re/lib/simd/simd.hpp>
 #include "common.hpp"
 
@@ -18,6 +19,7 @@ class simd_fft {
     static_assert(std::is_floating_point<T>::value);
     static_assert((N & (N - 1)) == 0, "N must be a power of 2.");
     static_assert(N >= 2*simd::width<cpx_t>);
+    static_assert(simd::width<cpx_t> <= 4, "stage 2 is the first vector stage");
 
     static constexpr int_t stride(int_t n_out) {
         return (n_out > 0) ? N / n_out : 0;
@@ -82,7 +84,6 @@ private:
 
     void loop(gsl::span<cpx_t, N> output) noexcept {
         for (auto i = 0; (1 << i) < N; ++i) {
-            set_twiddles(i);
             switch (i) {
                 case 0:
                     stage0(output);
@@ -90,11 +91,14 @@ private:
                 case 1:
                     stage1(output);
                     break;
-                case 2:
-                    stage2(output);
-                    break;
                 default:
-                    stage_2n(output, i++);
+                    if ((2 << i) < N) {
+                        set_twiddles(i + 1);
+                        stage_2n(output, i++);
+                    } else {
+                        set_twiddles(i);
+                        stage_n(output, i);
+                    }
                     break;
             }
         }
@@ -107,20 +111,14 @@ private:
         for (auto i = 0; i < n; ++i) {
             w_twiddles[i] = twiddles[i * stride];
         }
-        /*
-        for (auto i = 1; i * n < simd::width<cpx_t>; ++i) {
-            for (auto j = 0; j < n; ++j) {
-                w_twiddles[i * n + j] = w_twiddles[j];
-            }
-        }
-         */
     }
 
+    // Single radix-2 stage, expects the twiddles of the stage.
     void stage_n(gsl::span<cpx_t, N> out, int_t stage) const noexcept {
         auto const stride = 1 << stage;
 
         for (auto j = 0; j < stride; j += simd::width<cpx_t>) {
-            auto w = simd::load(&w_twiddles[j]);
+            auto w = simd::load_aligned(&w_twiddles[j]);
             for (auto i = 0; i < N; i += 2*stride) {
                 auto x_a = simd::load(&out[j + i]);
                 auto x_b = simd::load(&out[j + i + stride]);
@@ -135,13 +133,19 @@ private:
         }
     }
 
+    // Two radix-2 stages in one pass over the data, expects the twiddles of
+    // the second stage. With v = W(4m, j), the first stage multiplies by v²
+    // and the second by v and -iv.
     void stage_2n(gsl::span<cpx_t, N> out, int_t stage) const noexcept {
         auto const stride = 1 << stage;
 
         for (auto j = 0; j < stride; j += simd::width<cpx_t>) {
-            auto w1 = simd::load(&w_twiddles[j]);
-            auto w2 = simd::intrinsics::mul<cpx_t>()(w1, w1);
-            auto w3 = simd::intrinsics::mul<cpx_t>()(w1, w2);
+            auto v = simd::load_aligned(&w_twiddles[j]);
+            auto v_flipped = v;
+            for (auto& t : v_flipped.a) {
+                t = flip<direction::forward>(t);
+            }
+            auto w = simd::intrinsics::mul<cpx_t>()(v, v);
 
             for (auto i = 0; i < N; i += 4*stride) {
                 auto x_a = simd::load(&out[j + i + 0 * stride]);
@@ -149,22 +153,21 @@ private:
                 auto x_c = simd::load(&out[j + i + 2 * stride]);
                 auto x_d = simd::load(&out[j + i + 3 * stride]);
 
-                auto w_x_b = simd::intrinsics::mul<cpx_t>()(x_b, w1);
-                auto w_x_c = simd::intrinsics::mul<cpx_t>()(x_c, w2);
-                auto w_x_d = simd::intrinsics::mul<cpx_t>()(x_d, w3);
+                auto w_x_b = simd::intrinsics::mul<cpx_t>()(x_b, w);
+                auto w_x_d = simd::intrinsics::mul<cpx_t>()(x_d, w);
 
-                x_d = simd::intrinsics::sub<cpx_t>()(w_x_c, w_x_d);
-                x_c = simd::intrinsics::add<cpx_t>()(w_x_c, w_x_d);
                 x_b = simd::intrinsics::sub<cpx_t>()(x_a, w_x_b);
                 x_a = simd::intrinsics::add<cpx_t>()(x_a, w_x_b);
+                x_d = simd::intrinsics::sub<cpx_t>()(x_c, w_x_d);
+                x_c = simd::intrinsics::add<cpx_t>()(x_c, w_x_d);
 
-                w_x_d = x_d;
-                x_d = simd::intrinsics::sub<cpx_t>()(x_b, w_x_d);
-                x_b = simd::intrinsics::add<cpx_t>()(x_b, w_x_d);
+                auto v_x_c = simd::intrinsics::mul<cpx_t>()(x_c, v);
+                auto v_x_d = simd::intrinsics::mul<cpx_t>()(x_d, v_flipped);
 
-                w_x_c = x_c;
-                x_c = simd::intrinsics::sub<cpx_t>()(x_a, w_x_c);
-                x_a = simd::intrinsics::add<cpx_t>()(x_a, w_x_c);
+                x_c = simd::intrinsics::sub<cpx_t>()(x_a, v_x_c);
+                x_a = simd::intrinsics::add<cpx_t>()(x_a, v_x_c);
+                x_d = simd::intrinsics::sub<cpx_t>()(x_b, v_x_d);
+                x_b = simd::intrinsics::add<cpx_t>()(x_b, v_x_d);
 
                 simd::store(&out[j + i + 0 * stride], x_a);
                 simd::store(&out[j + i + 1 * stride], x_b);
@@ -174,39 +177,6 @@ private:
         }
     }
 
-    void stage3(gsl::span<cpx_t, N> out) const noexcept {
-        for (auto j = 0u; j < 8; j += simd::width<cpx_t>) {
-            auto w = simd::load(&w_twiddles[j]);
-            for (auto i = 0u; i < N; i += 16) {
-                auto x_a = simd::load(&out[j + i + 0]);
-                auto x_b = simd::load(&out[j + i + 8]);
-                auto w_x_b = simd::multiply(x_b, w);
-                x_a = simd::add(x_a, w_x_b);
-                x_b = simd::subtract(x_a, w_x_b);
-
-                simd::store(&out[j + i + 0], x_a);
-                simd::store(&out[j + i + 8], x_b);
-            }
-        }
-    }
-
-
-    void stage2(gsl::span<cpx_t, N> out) const noexcept {
-        for (auto j = 0u; j < 4; j += simd::width<cpx_t>) {
-            auto w = simd::load(&w_twiddles[j]);
-            for (auto i = 0u; i < N; i += 8) {
-                auto x_a = simd::load(&out[j + i + 0]);
-                auto x_b = simd::load(&out[j + i + 4]);
-                auto w_x_b = simd::multiply(x_b, w);
-                x_a = simd::add(x_a, w_x_b);
-                x_b = simd::subtract(x_a, w_x_b);
-
-                simd::store(&out[j + i + 0], x_a);
-                simd::store(&out[j + i + 4], x_b);
-            }
-        }
-    }
-
     void stage1(gsl::span<cpx_t, N> out) const noexcept {
         for (auto i = 0u; i < N; i += 4) {
             auto x_a = out[i];
@@ -229,8 +199,8 @@ private:
         }
     }
 
-    std::array<cpx_t, N/2> twiddles;
-    std::array<cpx_t, N/2> __attribute__((aligned (16))) w_twiddles;
+    simd::aligned_array<cpx_t, N/2> twiddles;
+    simd::aligned_array<cpx_t, N/2> w_twiddles;
 };
 
 }
@@ -1,11 +1,17 @@
 #pragma once
 
 #include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
 #include <gsl/span>
 
 #include <re/lib/common.hpp>
-#include <re/lib/container/ring_array.hpp>
+#include <re/lib/container/sliding_percentile.hpp>
 #include <re/lib/math/mean.hpp>
+#include <re/lib/math/prefix_sum.hpp>
+#include <re/lib/simd/simd.hpp>
 
 namespace re {
 namespace math {
@@ -41,44 +47,347 @@ void threshold_reference(
     );
 }
 
+// Subtracts from each value the mean of the values within radius of it,
+// clipping at zero, for a signal that arrives piece by piece. A window
+// reaching past either end of the signal is cut short there and averages
+// the values it does cover.
+//
+// Window sums are differences of prefix sums, so each output costs the
+// same for any radius, and the outputs that have their whole window within
+// the signal are computed width<T> at a time. The prefix sums restart now
+// and then from the oldest value still needed, which keeps them from
+// growing with the length of the stream and losing precision.
+template <typename T>
+class streaming_threshold {
+public:
+    explicit streaming_threshold(int_t radius) :
+        r(radius),
+        sums(1, T{0})
+    {
+        assert(radius >= 0);
+    }
+
+    int_t radius()
+    const noexcept {
+        return r;
+    }
+
+    // Takes the next values of the signal and writes the outputs whose
+    // windows they complete, which lag radius() values behind. out needs
+    // room for as many values as in. Returns how many were written.
+    int_t push(gsl::span<T const> in, gsl::span<T> out) {
+        assert(std::size(out) >= std::size(in));
+        auto const old = static_cast<int_t>(values.size());
+        values.insert(std::end(values), std::cbegin(in), std::cend(in));
+        sums.resize(values.size() + 1);
+        prefix_sum(
+            gsl::span<T const>(values).subspan(old),
+            gsl::span<T>(sums).subspan(old + 1),
+            sums[old]
+        );
+        seen += std::size(in);
+
+        auto const written = emit(out, seen - r);
+        if (std::max(done - r, int_t{0}) - base >= rebase_interval) {
+            rebase();
+        }
+        return written;
+    }
+
+    // Writes the outputs still missing, whose windows end with the signal,
+    // and starts over with a new signal. Returns how many were written.
+    int_t flush(gsl::span<T> out) {
+        auto const written = emit(out, seen);
+        values.clear();
+        sums.assign(1, T{0});
+        base = seen = done = 0;
+        return written;
+    }
+
+private:
+    // Values before the oldest one still needed are dropped in batches of
+    // at least this many.
+    static constexpr int_t rebase_interval = 4096;
+
+    // Writes the outputs from done up to last.
+    int_t emit(gsl::span<T> out, int_t last)
+    noexcept {
+        auto const first = done;
+        auto const x = [this] (int_t j) { return values.data() + (j - base); };
+        auto const p = [this] (int_t j) { return sums.data() + (j - base); };
+        auto const scalar = [&] (int_t j) {
+            auto const lo = std::max(j - r, int_t{0});
+            auto const hi = std::min(j + r, seen - 1);
+            auto const sum = *p(hi + 1) - *p(lo);
+            auto const mean = sum / static_cast<T>(hi - lo + 1);
+            out[j - first] = std::fdim(*x(j), mean);
+        };
+
+        auto j = first;
+        for (; j < std::min(last, r); ++j) {
+            scalar(j);
+        }
+
+        constexpr auto width = simd::width<T>;
+        auto const count = simd::set_lane(static_cast<T>(2*r + 1));
+        auto const zero = simd::intrinsics::zero<T>();
+        for (; j + width <= std::min(last, seen - r); j += width) {
+            auto const sum = simd::subtract(
+                simd::load(p(j + r + 1)),
+                simd::load(p(j - r))
+            );
+            auto const excess = simd::subtract(
+                simd::load(x(j)),
+                simd::divide(sum, count)
+            );
+            simd::store(
+                out.data() + (j - first),
+                simd::intrinsics::max<T>()(excess, zero)
+            );
+        }
+
+        for (; j < last; ++j) {
+            scalar(j);
+        }
+        done = std::max(done, last);
+        return done - first;
+    }
+
+    // Drops the values no window needs any more and restarts the prefix
+    // sums at the oldest of the rest.
+    void rebase() {
+        auto const keep = std::max(done - r, int_t{0});
+        values.erase(std::begin(values), std::begin(values) + (keep - base));
+        base = keep;
+        sums.resize(values.size() + 1);
+        prefix_sum(
+            gsl::span<T const>(values),
+            gsl::span<T>(sums).subspan(1),
+            T{0}
+        );
+    }
+
+    int_t r;
+    std::vector<T> values;
+    std::vector<T> sums;
+    int_t base = 0;
+    int_t seen = 0;
+    int_t done = 0;
+};
+
+template <typename T, int_t N_in, int_t N_out>
+void
+adaptive_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    int_t radius
+) {
+    assert(std::size(in) == std::size(out));
+    constexpr int_t block = 4096;
+    auto const n = std::size(in);
+
+    streaming_threshold<T> threshold(radius);
+    int_t written = 0;
+    for (int_t i = 0; i < n; i += block) {
+        written += threshold.push(
+            in.subspan(i, std::min(block, n - i)),
+            out.subspan(written)
+        );
+    }
+    threshold.flush(out.subspan(written));
+}
+
 template <int_t Radius, typename T, int_t N_in, int_t N_out>
 void
 adaptive_threshold(
     gsl::span<T const, N_in> in,
     gsl::span<T, N_out> out
+) {
+    adaptive_threshold(in, out, Radius);
+}
+
+template <int_t Radius, typename T, int_t N>
+void
+adaptive_threshold(gsl::span<T, N> data) {
+    adaptive_threshold<Radius, T, N>(data, data);
+}
+
+
+// Like adaptive_threshold, with a percentile of the 2 * radius + 1 values
+// around each one instead of their mean, which a burst of strong onsets
+// does not drag up. Past either end the signal is taken to continue with
+// its edge value. Window is sliding_percentile, or any type with
+// push_back() and value() that keeps an order statistic of a window.
+template <typename Window, typename T, int_t N_in, int_t N_out>
+void
+order_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    Window window,
+    int_t radius
 ) noexcept {
     assert(std::size(in) == std::size(out));
     auto const n = std::size(in);
+    if (n == 0) {
+        return;
+    }
+
+    for (int_t i = 1; i <= radius; ++i) {
+        window.push_back(in[std::min(i, n - 1)]);
+    }
+    for (int_t i = 0; i < n; ++i) {
+        auto const threshold = window.value();
+        auto const next = in[std::min(i + radius + 1, n - 1)];
+        out[i] = std::fdim(in[i], threshold);
+        window.push_back(next);
+    }
+}
 
-    assert(n >= 2*Radius);
-    T sum = 0;
-    int_t count = 0;
-    ring_array<T, Radius> temp;
+// One round of the network below, on the pairs from First on.
+template <typename T, std::size_t N, std::size_t First, std::size_t... J>
+void
+exchange_pairs(
+    simd::vec_t<T> (&v)[N],
+    std::index_sequence<J...>
+) noexcept {
+    simd::intrinsics::min<T> min;
+    simd::intrinsics::max<T> max;
+    auto const exchange = [&] (std::size_t j) {
+        simd::lane<T> const a(v[j]);
+        simd::lane<T> const b(v[j + 1]);
+        v[j] = min(a, b).v;
+        v[j + 1] = max(a, b).v;
+    };
+    (exchange(First + 2 * J), ...);
+}
 
-    for (auto i = 0; i < n + Radius; ++i) {
-        if (i < n) {
-            sum += in[i];
-            ++count;
+// Sorts each lane across the vectors, by odd-even transposition. The
+// network is unrolled at compile time, which GCC stops doing by itself for
+// about ten vectors, and the vectors are kept as vec_t rather than lanes,
+// which GCC copies through general purpose registers.
+template <typename T, std::size_t N, std::size_t Round = 0>
+void
+sort_lanes(simd::vec_t<T> (&v)[N])
+noexcept {
+    if constexpr (Round < N) {
+        exchange_pairs<T, N, Round % 2>(
+            v,
+            std::make_index_sequence<(N - Round % 2) / 2>()
+        );
+        sort_lanes<T, N, Round + 1>(v);
+    }
+}
+
+// order_threshold for short windows known at compile time. Instead of
+// updating one window per value, the windows of width<T> consecutive
+// values are loaded as Length shifted vectors and sorted lane-wise by a
+// network of min and max, which yields width<T> thresholds at once and
+// carries no state from one block to the next. The network grows with the
+// square of Length, so this pays for short windows only.
+template <std::size_t Length, typename T, int_t N_in, int_t N_out>
+void
+sorted_lanes_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    std::size_t rank
+) {
+    static_assert(Length % 2 == 1);
+    assert(std::size(in) == std::size(out) && rank < Length);
+    constexpr auto radius = static_cast<int_t>(Length / 2);
+    constexpr auto width = simd::width<T>;
+    auto const n = std::size(in);
+    if (n == 0) {
+        return;
+    }
+
+    std::vector<T> padded(static_cast<std::size_t>(n + 2*radius + width));
+    std::fill(std::begin(padded), std::begin(padded) + radius, in[0]);
+    std::copy(std::cbegin(in), std::cend(in), std::begin(padded) + radius);
+    std::fill(std::begin(padded) + radius + n, std::end(padded), in[n - 1]);
+
+    simd::lane<T> block;
+    simd::vec_t<T> window[Length];
+    for (int_t i = 0; i < n; i += width) {
+        auto const p = padded.data() + i;
+        for (std::size_t j = 0; j < Length; ++j) {
+            window[j] = simd::load(p + j).v;
         }
-        if (i >= Radius) {
-            auto const in_value = in[i - Radius];
-            out[i - Radius] = std::fdim(in_value, sum / count);
-            if (i > 2*Radius) {
-                sum -= temp.front();
-                --count;
-            }
-            temp.push_back(in_value);
+        sort_lanes<T>(window);
+
+        auto const threshold = simd::lane<T>(window[rank]);
+        block = simd::intrinsics::max<T>()(
+            simd::subtract(simd::load(p + radius), threshold),
+            simd::intrinsics::zero<T>()
+        );
+        if (i + width <= n) {
+            simd::store(out.data() + i, block);
+        } else {
+            std::copy(
+                std::cbegin(block.a),
+                std::cbegin(block.a) + (n - i),
+                out.data() + i
+            );
         }
     }
 }
 
-template <int_t Radius, typename T, int_t N>
+// Windows of up to this many values go through sorted_lanes_threshold.
+constexpr int_t sorted_lanes_limit = 15;
+
+template <int_t Radius, typename T, int_t N_in, int_t N_out>
 void
-adaptive_threshold(gsl::span<T, N> data)
-noexcept {
-    adaptive_threshold<Radius, T, N>(data, data);
+percentile_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    double q
+) {
+    constexpr auto length = static_cast<std::size_t>(2*Radius + 1);
+    if (std::size(in) == 0) {
+        return;
+    }
+
+    auto const rank = percentile_rank(length, q);
+    if constexpr (2*Radius + 1 <= sorted_lanes_limit) {
+        sorted_lanes_threshold<length>(in, out, rank);
+    } else {
+        order_threshold(
+            in,
+            out,
+            sliding_percentile<T>(length, rank, in[0]),
+            Radius
+        );
+    }
+}
+
+template <typename T, int_t N_in, int_t N_out>
+void
+percentile_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    int_t radius,
+    double q
+) {
+    auto const length = static_cast<std::size_t>(2*radius + 1);
+    if (std::size(in) == 0) {
+        return;
+    }
+
+    order_threshold(
+        in,
+        out,
+        sliding_percentile<T>(length, percentile_rank(length, q), in[0]),
+        radius
+    );
 }
 
+template <int_t Radius, typename T, int_t N_in, int_t N_out>
+void
+median_threshold(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out
+) {
+    percentile_threshold<Radius>(in, out, 0.5);
+}
 
 }
 }
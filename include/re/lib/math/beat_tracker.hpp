@@ -0,0 +1,379 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/math/element.hpp>
+#include <re/lib/math/reductions.hpp>
+#include <re/lib/simd/simd.hpp>
+
+// Beat tracking by dynamic programming over an onset function (Ellis,
+// "Beat Tracking by Dynamic Programming", 2007). The cumulative score of
+// a frame is its onset value plus the best, over the frames from half a
+// period to two periods before it, of their cumulative score plus a
+// penalty on the log of the ratio of the gap to the period. Following
+// the best predecessors back from the end gives the beats.
+
+namespace re {
+namespace math {
+
+// Weights of the predecessors of a frame for a period given in frames
+// and a tightness: -tightness * log(d / period)^2 for the gaps d from
+// nearest() to farthest().
+template <typename T>
+class beat_transition {
+public:
+    explicit beat_transition(double period, double tightness = 100) :
+        p(period),
+        lo(std::max(static_cast<int_t>(std::lround(period / 2)), int_t{1})),
+        hi(std::max(static_cast<int_t>(std::lround(2 * period)), lo)),
+        w(hi - lo + 1)
+    {
+        assert(period >= 1 && tightness >= 0);
+        for (int_t d = lo; d <= hi; ++d) {
+            auto const x = std::log(d / period);
+            w[hi - d] = static_cast<T>(-tightness * x * x);
+        }
+    }
+
+    double period()
+    const noexcept {
+        return p;
+    }
+
+    int_t nearest()
+    const noexcept {
+        return lo;
+    }
+
+    int_t farthest()
+    const noexcept {
+        return hi;
+    }
+
+    // Farthest first, so the k-th weight goes with the frame k after
+    // the first of the window.
+    gsl::span<T const> weights()
+    const noexcept {
+        return gsl::span<T const>(w);
+    }
+
+private:
+    double p;
+    int_t lo;
+    int_t hi;
+    std::vector<T> w;
+};
+
+// Cumulative scores of n frames in place after the scores of those before
+// them: scores[i] = onsets[i] + max(scores[i - d] + weight(d)), and
+// links[i] the frame of the best, counted from first at scores[0], or -1
+// if every score in the window is -infinity, when scores[i] = onsets[i].
+// scores[-farthest()] to scores[-1] must be readable. Of equal candidates
+// the farthest wins.
+//
+// Once the nearest predecessor is a lane away, the scores of width<T>
+// frames at a time only depend on earlier lanes, so the scan runs across
+// frames and every gap costs one vector add, compare and two blends for
+// all of them, the argmax riding along as the gap of the best. Otherwise
+// each frame takes the argmax of its window with max_result.
+template <typename T>
+void max_plus_scan(
+    beat_transition<T> const& window,
+    T const* onsets,
+    T* scores,
+    int_t* links,
+    int_t n,
+    int_t first = 0
+) noexcept {
+    constexpr auto width = simd::width<T>;
+    auto const lo = window.nearest();
+    auto const hi = window.farthest();
+    auto const w = window.weights();
+    auto const none = -std::numeric_limits<T>::infinity();
+
+    int_t i = 0;
+    if (lo >= width) {
+        simd::intrinsics::greater<T> greater;
+        simd::intrinsics::select<T> select;
+        auto const nothing = simd::set_lane(none);
+        auto const zero = simd::intrinsics::zero<T>();
+        // Four chains over successive quarters of the window, from the far
+        // end, keep the compares and blends of one from waiting for the
+        // last. A nearer chain takes over only with a higher score.
+        constexpr int_t chains = 4;
+        for (; i + width <= n; i += width) {
+            std::array<simd::lane<T>, chains> best, gap;
+            best.fill(nothing);
+            gap.fill(zero);
+            auto const step = [&] (int_t c, int_t d) {
+                auto const candidate = simd::add(
+                    simd::load(scores + i - d),
+                    simd::set_lane(w[hi - d])
+                );
+                auto const mask = greater(candidate, best[c]);
+                best[c] = select(mask, candidate, best[c]);
+                gap[c] = select(
+                    mask,
+                    simd::set_lane(static_cast<T>(d)),
+                    gap[c]
+                );
+            };
+            auto const part = (hi - lo + 1) / chains;
+            for (auto d = hi; d > hi - part; --d) {
+                for (int_t c = 0; c < chains; ++c) {
+                    step(c, d - c * part);
+                }
+            }
+            for (auto d = hi - chains * part; d >= lo; --d) {
+                step(chains - 1, d);
+            }
+            for (int_t c = 1; c < chains; ++c) {
+                auto const nearer = greater(best[c], best[0]);
+                best[0] = select(nearer, best[c], best[0]);
+                gap[0] = select(nearer, gap[c], gap[0]);
+            }
+            auto const found = greater(best[0], nothing);
+            simd::store(
+                scores + i,
+                simd::add(simd::load(onsets + i), select(found, best[0], zero))
+            );
+            for (int_t j = 0; j < width; ++j) {
+                links[i + j] = gap[0].a[j] > 0
+                    ? first + i + j - static_cast<int_t>(gap[0].a[j])
+                    : -1;
+            }
+        }
+    }
+
+    for (; i < n; ++i) {
+        auto const best = max_result(
+            gsl::span<T const>(scores + i - hi, hi - lo + 1),
+            w,
+            simd::intrinsics::add<T>()
+        );
+        if (best.value > none) {
+            scores[i] = onsets[i] + best.value;
+            links[i] = first + i - hi + static_cast<int_t>(best.index);
+        } else {
+            scores[i] = onsets[i];
+            links[i] = -1;
+        }
+    }
+}
+
+// The best cumulative score within the last period of scores, the end
+// of the best path. Of equal scores the first wins.
+template <typename T, int_t N>
+element<T>
+last_beat(gsl::span<T const, N> scores, beat_transition<T> const& window)
+noexcept {
+    assert(std::size(scores) > 0);
+    auto const n = static_cast<int_t>(std::size(scores));
+    auto const span = std::min(
+        std::max(static_cast<int_t>(std::lround(window.period())), int_t{1}),
+        n
+    );
+    auto const best = max(gsl::span<T const>(scores.data() + n - span, span));
+    return element<T>(
+        best.value,
+        best.index + static_cast<std::size_t>(n - span)
+    );
+}
+
+// Fills scores and links for a whole onset function.
+template <typename T, int_t N_in, int_t N_scores, int_t N_links>
+void cumulative_score(
+    gsl::span<T const, N_in> onsets,
+    beat_transition<T> const& window,
+    gsl::span<T, N_scores> scores,
+    gsl::span<int_t, N_links> links
+) {
+    assert(std::size(scores) == std::size(onsets));
+    assert(std::size(links) == std::size(onsets));
+    auto const hi = window.farthest();
+    std::vector<T> padded(
+        hi + std::size(onsets),
+        -std::numeric_limits<T>::infinity()
+    );
+    max_plus_scan(
+        window,
+        onsets.data(),
+        padded.data() + hi,
+        links.data(),
+        std::size(onsets)
+    );
+    std::copy(std::cbegin(padded) + hi, std::cend(padded), std::begin(scores));
+}
+
+// The frames of the beats of a whole onset function, in order.
+template <typename T, int_t N>
+std::vector<int_t>
+track_beats(gsl::span<T const, N> onsets, beat_transition<T> const& window) {
+    auto const n = static_cast<int_t>(std::size(onsets));
+    if (n == 0) {
+        return {};
+    }
+
+    std::vector<T> scores(n);
+    std::vector<int_t> links(n);
+    cumulative_score(
+        onsets,
+        window,
+        gsl::span<T>(scores),
+        gsl::span<int_t>(links)
+    );
+
+    std::vector<int_t> beats;
+    auto b = static_cast<int_t>(
+        last_beat(gsl::span<T const>(scores), window).index
+    );
+    for (; b >= 0; b = links[b]) {
+        beats.push_back(b);
+    }
+    std::reverse(std::begin(beats), std::end(beats));
+    return beats;
+}
+
+// track_beats for an onset function that arrives piece by piece. Whether
+// a frame is a beat is decided latency() frames after it, on the best
+// path then, so the memory kept is the scores and links of the last
+// latency() + farthest() frames, plus what has arrived since the last
+// time the older ones were dropped. A later path that disagrees about
+// frames already decided is not taken back.
+template <typename T>
+class beat_tracker {
+public:
+    explicit beat_tracker(beat_transition<T> window) :
+        beat_tracker(window, 4 * window.farthest())
+    {
+    }
+
+    beat_tracker(beat_transition<T> window, int_t latency) :
+        window(std::move(window)),
+        lag(latency),
+        scores(this->window.farthest(), -std::numeric_limits<T>::infinity())
+    {
+        assert(latency >= 0);
+    }
+
+    int_t latency()
+    const noexcept {
+        return lag;
+    }
+
+    // Takes the next onset values and writes the frames of the beats among
+    // those now decided, which lag latency() frames behind. out needs room
+    // for as many values as in. Returns how many were written.
+    int_t push(gsl::span<T const> in, gsl::span<int_t> out) {
+        assert(std::size(out) >= std::size(in));
+        auto const m = static_cast<int_t>(std::size(in));
+        if (m == 0) {
+            return 0;
+        }
+
+        scores.resize(scores.size() + m);
+        links.resize(links.size() + m);
+        max_plus_scan(
+            window,
+            in.data(),
+            score(seen),
+            links.data() + (seen - base),
+            m,
+            seen
+        );
+        seen += m;
+
+        auto const written = decide(out, seen - 1 - lag);
+        if (decided - window.farthest() - base >= rebase_interval) {
+            rebase();
+        }
+        return written;
+    }
+
+    // Writes the beats of the frames still undecided, on the best path at
+    // the end, and starts over with a new onset function. out needs room
+    // for latency() values. Returns how many were written.
+    int_t flush(gsl::span<int_t> out) {
+        auto const written = decide(out, seen - 1);
+        scores.assign(window.farthest(), -std::numeric_limits<T>::infinity());
+        links.clear();
+        base = seen = 0;
+        decided = -1;
+        return written;
+    }
+
+private:
+    // Frames before the oldest one still needed are dropped in batches of
+    // at least this many.
+    static constexpr int_t rebase_interval = 4096;
+
+    T* score(int_t frame)
+    noexcept {
+        return scores.data() + (frame - base + window.farthest());
+    }
+
+    // Writes the beats of the best path after decided up to last.
+    int_t decide(gsl::span<int_t> out, int_t last) {
+        if (last <= decided) {
+            return 0;
+        }
+
+        auto const end = seen - base;
+        auto b = base + static_cast<int_t>(last_beat(
+            gsl::span<T const>(score(base), end),
+            window
+        ).index);
+        path.clear();
+        for (; b > decided && b >= base; b = links[b - base]) {
+            if (b <= last) {
+                path.push_back(b);
+            }
+        }
+        decided = last;
+
+        assert(std::size(out) >= static_cast<int_t>(path.size()));
+        std::reverse_copy(std::cbegin(path), std::cend(path), out.data());
+        return static_cast<int_t>(path.size());
+    }
+
+    // Drops the frames no path can still reach and takes the largest
+    // score off the rest, which leaves every choice as it was.
+    void rebase() {
+        auto const oldest = decided - window.farthest();
+        auto const dropped = oldest - base;
+        scores.erase(std::begin(scores), std::begin(scores) + dropped);
+        links.erase(std::begin(links), std::begin(links) + dropped);
+        base = oldest;
+
+        auto const top = *std::max_element(
+            std::cbegin(scores),
+            std::cend(scores)
+        );
+        for (auto& s : scores) {
+            s -= top;
+        }
+    }
+
+    beat_transition<T> window;
+    int_t lag;
+    // Scores from farthest() frames before base, links from base.
+    std::vector<T> scores;
+    std::vector<int_t> links;
+    std::vector<int_t> path;
+    int_t base = 0;
+    int_t seen = 0;
+    int_t decided = -1;
+};
+
+}
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/simd/denormals.hpp>
+#include <re/lib/simd/simd.hpp>
+
+namespace re {
+namespace math {
+
+// Coefficients of a second order section normalized so that a0 = 1:
+//
+//     y[t] = b0 x[t] + b1 x[t-1] + b2 x[t-2] - a1 y[t-1] - a2 y[t-2]
+//
+// The designs are those of the Audio EQ Cookbook, for a frequency given
+// in cycles per sample, below 0.5.
+template <typename T>
+struct biquad {
+    T b0 = 1;
+    T b1 = 0;
+    T b2 = 0;
+    T a1 = 0;
+    T a2 = 0;
+
+    static biquad lowpass(double frequency, double q = 0.7071067811865476)
+    noexcept {
+        auto const c = std::cos(2 * pi<double> * frequency);
+        return normalized(q, frequency, (1 - c) / 2, 1 - c, (1 - c) / 2);
+    }
+
+    static biquad highpass(double frequency, double q = 0.7071067811865476)
+    noexcept {
+        auto const c = std::cos(2 * pi<double> * frequency);
+        return normalized(q, frequency, (1 + c) / 2, -(1 + c), (1 + c) / 2);
+    }
+
+    // Unit gain at the centre frequency.
+    static biquad bandpass(double frequency, double q)
+    noexcept {
+        auto const alpha = std::sin(2 * pi<double> * frequency) / (2 * q);
+        return normalized(q, frequency, alpha, 0, -alpha);
+    }
+
+private:
+    static biquad normalized(
+        double q,
+        double frequency,
+        double b0,
+        double b1,
+        double b2
+    ) noexcept {
+        assert(frequency > 0 && frequency < 0.5 && q > 0);
+        auto const w = 2 * pi<double> * frequency;
+        auto const alpha = std::sin(w) / (2 * q);
+        auto const a0 = 1 + alpha;
+        biquad result;
+        result.b0 = static_cast<T>(b0 / a0);
+        result.b1 = static_cast<T>(b1 / a0);
+        result.b2 = static_cast<T>(b2 / a0);
+        result.a1 = static_cast<T>(-2 * std::cos(w) / a0);
+        result.a2 = static_cast<T>((1 - alpha) / a0);
+        return result;
+    }
+};
+
+// size() independent filters of stages() second order sections each, run
+// a lane of filters at a time. The sections are in transposed direct form
+// II, which keeps two values of state per section:
+//
+//     y = b0 x + s1,  s1 = b1 x - a1 y + s2,  s2 = b2 x - a2 y
+//
+// A lane of filters goes through a piece of signal one section at a time,
+// with the coefficients and state of the section in registers, so the
+// recursion is all that is left in the inner loop. Filters start out
+// passing their input through, with zero state.
+//
+// A filter left ringing into silence decays towards subnormal values,
+// which are slow to compute with. Calls run with them flushed to zero
+// where the processor can, and afterwards set state below silence() to
+// zero, so a silent input soon gives exactly zero.
+template <typename T>
+class biquad_bank {
+public:
+    explicit biquad_bank(int_t filters, int_t stages = 1) :
+        m(filters),
+        count(stages),
+        blocks((filters + width - 1) / width),
+        coefficients(blocks * stages * 5 * width),
+        state(blocks * stages * 2 * width, T{0}),
+        scratch(chunk * width)
+    {
+        assert(filters > 0 && stages > 0);
+        for (int_t filter = 0; filter < filters; ++filter) {
+            for (int_t stage = 0; stage < stages; ++stage) {
+                set(filter, stage, biquad<T>());
+            }
+        }
+    }
+
+    // Number of filters.
+    int_t size()
+    const noexcept {
+        return m;
+    }
+
+    int_t stages()
+    const noexcept {
+        return count;
+    }
+
+    static constexpr T silence()
+    noexcept {
+        return T(1e-30);
+    }
+
+    void set(int_t filter, int_t stage, biquad<T> const& section)
+    noexcept {
+        assert(filter >= 0 && filter < m && stage >= 0 && stage < count);
+        auto const lane = filter % width;
+        auto* c = coefficients.data()
+            + ((filter / width) * count + stage) * 5 * width;
+        c[0 * width + lane] = section.b0;
+        c[1 * width + lane] = section.b1;
+        c[2 * width + lane] = section.b2;
+        c[3 * width + lane] = -section.a1;
+        c[4 * width + lane] = -section.a2;
+    }
+
+    // Zeroes the state of every filter.
+    void reset()
+    noexcept {
+        std::fill(std::begin(state), std::end(state), T{0});
+    }
+
+    // Runs every filter on a channel of its own. in and out hold frames of
+    // size() values, one per filter, one frame after another. in and out
+    // may be the same span.
+    void process(gsl::span<T const> in, gsl::span<T> out)
+    noexcept {
+        assert(std::size(in) % m == 0);
+        assert(std::size(in) == std::size(out));
+        run(std::size(in) / m, [&] (int_t first, int_t t, int_t offset) {
+            return read(
+                in.data() + (first + t) * m + offset,
+                std::min(width, m - offset)
+            );
+        }, out);
+    }
+
+    // Runs every filter on the same signal, as for a bank of bands. out
+    // holds a frame of size() values per value of in.
+    void split(gsl::span<T const> in, gsl::span<T> out)
+    noexcept {
+        assert(std::size(out) == std::size(in) * m);
+        run(std::size(in), [&] (int_t first, int_t t, int_t) {
+            return simd::set_lane(in[first + t]);
+        }, out);
+    }
+
+private:
+    static constexpr int_t width = simd::width<T>;
+    // Samples that go through one section before the next.
+    static constexpr int_t chunk = 256;
+
+    static simd::lane<T> read(T const* p, int_t lanes)
+    noexcept {
+        if (lanes == width) {
+            return simd::load(p);
+        }
+        auto x = simd::intrinsics::zero<T>();
+        for (int_t j = 0; j < lanes; ++j) {
+            x.a[j] = p[j];
+        }
+        return x;
+    }
+
+    static void write(T* p, simd::lane<T> const& y, int_t lanes)
+    noexcept {
+        if (lanes == width) {
+            simd::store(p, y);
+            return;
+        }
+        for (int_t j = 0; j < lanes; ++j) {
+            p[j] = y.a[j];
+        }
+    }
+
+    // The coefficients and state of a section for a lane of filters, held
+    // in registers while it runs.
+    struct section {
+        section(T const* c, T const* s, int_t stage)
+        noexcept :
+            b0(simd::load(c + stage * 5 * width)),
+            b1(simd::load(c + stage * 5 * width + width)),
+            b2(simd::load(c + stage * 5 * width + 2 * width)),
+            a1(simd::load(c + stage * 5 * width + 3 * width)),
+            a2(simd::load(c + stage * 5 * width + 4 * width)),
+            s1(simd::load(s + stage * 2 * width)),
+            s2(simd::load(s + stage * 2 * width + width))
+        {
+        }
+
+        simd::lane<T> operator()(simd::lane<T> x)
+        noexcept {
+            simd::intrinsics::mul_add<T> mul_add;
+            auto const y = mul_add(b0, x, s1);
+            s1 = mul_add(a1, y, mul_add(b1, x, s2));
+            s2 = mul_add(a2, y, simd::multiply(b2, x));
+            return y;
+        }
+
+        void save(T* s, int_t stage)
+        const noexcept {
+            simd::store(s + stage * 2 * width, s1);
+            simd::store(s + stage * 2 * width + width, s2);
+        }
+
+        simd::lane<T> b0, b1, b2, a1, a2;
+        simd::lane<T> s1, s2;
+    };
+
+    // Filters n frames block by block and chunk by chunk. input(first, t,
+    // offset) is the lane of input at frame first + t to the filters of
+    // the block that starts offset filters into the frame.
+    template <typename Input>
+    void run(int_t n, Input input, gsl::span<T> out)
+    noexcept {
+        simd::flush_to_zero const guard;
+        for (int_t block = 0; block < blocks; ++block) {
+            auto const offset = block * width;
+            auto const lanes = std::min(width, m - offset);
+            auto* c = coefficients.data() + block * count * 5 * width;
+            auto* s = state.data() + block * count * 2 * width;
+
+            for (int_t first = 0; first < n; first += chunk) {
+                auto const length = std::min(chunk, n - first);
+                for (int_t t = 0; t < length; ++t) {
+                    simd::store(
+                        scratch.data() + t * width,
+                        input(first, t, offset)
+                    );
+                }
+
+                // Two sections at a time, whose recursions overlap.
+                int_t stage = 0;
+                for (; stage + 1 < count; stage += 2) {
+                    section first_section(c, s, stage);
+                    section second_section(c, s, stage + 1);
+                    for (int_t t = 0; t < length; ++t) {
+                        auto* p = scratch.data() + t * width;
+                        simd::store(
+                            p,
+                            second_section(first_section(simd::load(p)))
+                        );
+                    }
+                    first_section.save(s, stage);
+                    second_section.save(s, stage + 1);
+                }
+                if (stage < count) {
+                    section last_section(c, s, stage);
+                    for (int_t t = 0; t < length; ++t) {
+                        auto* p = scratch.data() + t * width;
+                        simd::store(p, last_section(simd::load(p)));
+                    }
+                    last_section.save(s, stage);
+                }
+
+                for (int_t t = 0; t < length; ++t) {
+                    write(
+                        out.data() + (first + t) * m + offset,
+                        simd::load(scratch.data() + t * width),
+                        lanes
+                    );
+                }
+            }
+            flush(s);
+        }
+    }
+
+    // Sets the state of a block below silence() to zero.
+    void flush(T* s)
+    noexcept {
+        simd::intrinsics::max<T> max;
+        simd::intrinsics::less<T> less;
+        simd::intrinsics::select<T> select;
+        auto const zero = simd::intrinsics::zero<T>();
+        auto const floor = simd::set_lane(silence());
+        for (int_t i = 0; i < count * 2 * width; i += width) {
+            auto const v = simd::load(s + i);
+            auto const magnitude = max(v, simd::subtract(zero, v));
+            simd::store(s + i, select(less(magnitude, floor), zero, v));
+        }
+    }
+
+    int_t m;
+    int_t count;
+    int_t blocks;
+    // Per lane of filters and section, a lane each of b0, b1, b2, -a1 and
+    // -a2. Lanes past the last filter have all zero coefficients.
+    std::vector<T> coefficients;
+    // Per lane of filters and section, a lane each of s1 and s2.
+    std::vector<T> state;
+    std::vector<T> scratch;
+};
+
+}
+}
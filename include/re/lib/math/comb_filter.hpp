@@ -1,16 +1,28 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include <gsl/span>
 
 #include <re/lib/common.hpp>
+#include <re/lib/math/element.hpp>
 #include <re/lib/math/mean.hpp>
+#include <re/lib/math/prefix_sum.hpp>
+#include <re/lib/simd/simd.hpp>
 
 namespace re {
 namespace math {
 
+// Recursive definition of comb_filter for N_in a multiple of N_out, which
+// averages every window of every stage afresh.
 template <typename T, int_t N_in, int_t N_out>
 void
-comb_filter(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+comb_filter_reference(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
 noexcept {
     static_assert(N_in >= 0 && N_out >= 0);
     static_assert(N_in % N_out == 0);
@@ -19,7 +31,10 @@ noexcept {
     constexpr auto stage = N_in / N_out;
 
     if (stage > 1) {
-        comb_filter(gsl::span<T const, n_new>(in.data(), n_new), out);
+        comb_filter_reference(
+            gsl::span<T const, n_new>(in.data(), n_new),
+            out
+        );
     } else {
         std::fill(std::begin(out), std::end(out), 0);
     }
@@ -29,5 +44,295 @@ noexcept {
     }
 }
 
+// Scores periods by how much of in lines up with their multiples. out[i]
+// is for a period of i * step samples: the sum, over the multiples
+// s = 1, 2, ..., of the mean of in over the (2s - 1) * step samples
+// centred on sample s * i * step, which widens as the error of a period
+// known to within a step grows with s. Sample k covers [k, k + 1), so a
+// window may start or end part way into a sample when step is not a
+// whole number. Every output sums as many multiples as fit in for the
+// longest period, and out[0] is 0. For step 1 and std::size(in) a
+// multiple of std::size(out) this is comb_filter_reference.
+//
+// Each window mean is the difference of two points on the prefix sum of
+// in, read with vector gathers, so after one pass over in the cost is
+// constant per output and multiple however wide the windows get.
+template <typename T, int_t N_in, int_t N_out>
+void
+comb_filter(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    double step = 1
+) {
+    assert(step > 0);
+    assert(std::size(in) < std::numeric_limits<std::int32_t>::max());
+    constexpr auto width = simd::width<T>;
+    auto const n = std::size(in);
+    auto const m = std::size(out);
+
+    std::fill(std::begin(out), std::end(out), T{0});
+
+    // The window of the s-th multiple of period i is
+    // [s * i * step + 0.5 - half(s), s * i * step + 0.5 + half(s)).
+    auto const half = [step] (int_t s) {
+        return (s - 0.5) * step;
+    };
+    int_t multiples = 0;
+    while (m > 1
+           && (multiples + 1) * (m - 1) * step + 0.5 + half(multiples + 1)
+              <= n) {
+        ++multiples;
+    }
+    if (multiples == 0) {
+        return;
+    }
+
+    // sums[k] is the integral of in over [0, k). The extra element at the
+    // end lets a window that ends at n interpolate towards it.
+    std::vector<T> sums(n + 2);
+    prefix_sum(in, gsl::span<T>(sums.data() + 1, n));
+    sums[n + 1] = sums[n];
+
+    auto const integral = [&sums] (double x) {
+        auto const k = static_cast<std::int32_t>(x);
+        auto const f = static_cast<T>(x - k);
+        return sums[k] + f * (sums[k + 1] - sums[k]);
+    };
+    auto const integral_lane = [&sums] (
+        std::int32_t const* k,
+        simd::lane<T> f
+    ) {
+        auto const below = simd::load_gathered(sums.data(), k);
+        auto const above = simd::load_gathered(sums.data() + 1, k);
+        return simd::intrinsics::mul_add<T>()(
+            f,
+            simd::subtract(above, below),
+            below
+        );
+    };
+
+    for (int_t s = 1; s <= multiples; ++s) {
+        auto const stride = s * step;
+        auto const start = 0.5 - half(s);
+        auto const end = 0.5 + half(s);
+        auto const scale = static_cast<T>(1 / (2 * half(s)));
+
+        int_t i = 1;
+        for (; i + width <= m; i += width) {
+            std::int32_t lo[width], hi[width];
+            simd::lane<T> lo_fraction, hi_fraction;
+            for (int_t j = 0; j < width; ++j) {
+                auto const centre = (i + j) * stride;
+                auto const a = centre + start;
+                auto const b = centre + end;
+                lo[j] = static_cast<std::int32_t>(a);
+                hi[j] = static_cast<std::int32_t>(b);
+                lo_fraction.a[j] = static_cast<T>(a - lo[j]);
+                hi_fraction.a[j] = static_cast<T>(b - hi[j]);
+            }
+            auto const sum = simd::subtract(
+                integral_lane(hi, hi_fraction),
+                integral_lane(lo, lo_fraction)
+            );
+            simd::store(
+                out.data() + i,
+                simd::intrinsics::mul_add<T>()(
+                    sum,
+                    simd::set_lane(scale),
+                    simd::load(out.data() + i)
+                )
+            );
+        }
+        for (; i < m; ++i) {
+            auto const centre = i * stride;
+            out[i] += scale
+                * (integral(centre + end) - integral(centre + start));
+        }
+    }
+}
+
+// comb_filter for a fixed set of candidate periods, each given in samples,
+// scored against many inputs of the same length. A period p sums the
+// means over the windows of (2s - 1) * resolution samples centred on
+// sample s * p for s = 1 to multiples(), cut as in comb_filter, so the
+// periods i * step with resolution step give comb_filter's outputs.
+// Every window has to lie within the input: the last must end by length
+// and the first of the widest must start at 0 or later, which takes
+// p >= resolution - (resolution + 1) / (2 * multiples).
+//
+// Scoring is a sparse product: every window end puts two weights on
+// neighbouring points of the prefix sum of the input, and the weights
+// and positions are worked out once here. They are laid out a lane of
+// periods at a time, so the kernel streams through them in order and
+// keeps a lane's scores in registers until all of its windows are in.
+template <typename T>
+class comb_filter_bank {
+public:
+    comb_filter_bank(
+        int_t length,
+        gsl::span<double const> periods,
+        int_t multiples,
+        double resolution = 1
+    ) :
+        n(length),
+        m(std::size(periods)),
+        count(multiples),
+        blocks((m + width - 1) / width),
+        index(blocks * taps() * width),
+        below(index.size()),
+        above(index.size()),
+        split(blocks * taps()),
+        sums(n + 2),
+        scores(blocks * width),
+        ranked(m)
+    {
+        assert(length < std::numeric_limits<std::int32_t>::max());
+        assert(multiples > 0 && resolution > 0);
+
+        for (int_t period = 0; period < m; ++period) {
+            auto const p = periods[period];
+            auto const block = period / width;
+            auto const lane = period % width;
+            assert(count * p + count * resolution + 0.5 * (1 - resolution)
+                   <= n);
+
+            for (int_t s = 1; s <= count; ++s) {
+                auto const half = (s - 0.5) * resolution;
+                auto const scale = 1 / (2 * half);
+                assert(s * p + 0.5 - half >= 0);
+                set_tap(block, 2*s - 2, lane, s * p + 0.5 - half, -scale);
+                set_tap(block, 2*s - 1, lane, s * p + 0.5 + half, scale);
+            }
+        }
+    }
+
+    int_t length()
+    const noexcept {
+        return n;
+    }
+
+    // Number of periods.
+    int_t size()
+    const noexcept {
+        return m;
+    }
+
+    int_t multiples()
+    const noexcept {
+        return count;
+    }
+
+    // out[i] is the score of the i-th period.
+    template <int_t N_in, int_t N_out>
+    void score(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+    noexcept {
+        assert(std::size(out) == m);
+        apply(in);
+        std::copy(
+            std::cbegin(scores),
+            std::cbegin(scores) + m,
+            std::begin(out)
+        );
+    }
+
+    // The std::size(out) best scoring periods, or all of them if there
+    // are fewer, highest score first and the first period of equal ones
+    // before the others. Returns how many were written.
+    template <int_t N_in, int_t N_out>
+    int_t best(gsl::span<T const, N_in> in, gsl::span<element<T>, N_out> out)
+    noexcept {
+        apply(in);
+        for (int_t i = 0; i < m; ++i) {
+            ranked[i] = element<T>(scores[i], static_cast<std::size_t>(i));
+        }
+
+        auto const k = std::min(static_cast<int_t>(std::size(out)), m);
+        std::partial_sort(
+            std::begin(ranked),
+            std::begin(ranked) + k,
+            std::end(ranked),
+            [] (element<T> const& a, element<T> const& b) {
+                return a.value > b.value
+                    || (a.value == b.value && a.index < b.index);
+            }
+        );
+        std::copy(std::cbegin(ranked), std::cbegin(ranked) + k, out.data());
+        return k;
+    }
+
+private:
+    static constexpr int_t width = simd::width<T>;
+
+    int_t taps()
+    const noexcept {
+        return 2 * count;
+    }
+
+    // Spreads weight over the prefix sums on either side of x.
+    void set_tap(int_t block, int_t tap, int_t lane, double x, double weight)
+    noexcept {
+        auto const k = static_cast<std::int32_t>(x);
+        auto const f = x - k;
+        auto const at = (block * taps() + tap) * width + lane;
+        index[at] = k;
+        below[at] = static_cast<T>(weight * (1 - f));
+        above[at] = static_cast<T>(weight * f);
+        split[block * taps() + tap] |= f != 0;
+    }
+
+    void apply(gsl::span<T const> in)
+    noexcept {
+        assert(std::size(in) == n);
+        prefix_sum(in, gsl::span<T>(sums.data() + 1, n));
+        sums[n + 1] = sums[n];
+
+        auto const* k = index.data();
+        auto const* lower = below.data();
+        auto const* upper = above.data();
+        simd::intrinsics::mul_add<T> mul_add;
+        for (int_t block = 0; block < blocks; ++block) {
+            auto from_below = simd::intrinsics::zero<T>();
+            auto from_above = simd::intrinsics::zero<T>();
+            for (int_t tap = 0; tap < taps(); ++tap) {
+                from_below = mul_add(
+                    simd::load_gathered(sums.data(), k),
+                    simd::load(lower),
+                    from_below
+                );
+                if (split[block * taps() + tap]) {
+                    from_above = mul_add(
+                        simd::load_gathered(sums.data() + 1, k),
+                        simd::load(upper),
+                        from_above
+                    );
+                }
+                k += width;
+                lower += width;
+                upper += width;
+            }
+            simd::store(
+                scores.data() + block * width,
+                simd::add(from_below, from_above)
+            );
+        }
+    }
+
+    int_t n;
+    int_t m;
+    int_t count;
+    int_t blocks;
+    // Per lane of periods and tap, a lane each of positions and weights.
+    // Lanes past the last period keep position 0 and weight 0.
+    std::vector<std::int32_t> index;
+    std::vector<T> below;
+    std::vector<T> above;
+    // Whether any window end of the lane and tap falls inside a sample.
+    // The others leave out the gather for above.
+    std::vector<unsigned char> split;
+    std::vector<T> sums;
+    std::vector<T> scores;
+    std::vector<element<T>> ranked;
+};
+
 }
 }
@@ -28,7 +28,7 @@ struct element
     {
     }
 
-    element(T& value, std::size_t index) :
+    element(T const& value, std::size_t index) :
         value(value),
         index(index)
     {
@@ -78,8 +78,8 @@ auto max_result(
     auto largest1 = first1;
     auto largest_value = op(*first1, *first2);
 
-    while (it1 != last1) {
-        auto value = op(*(++it1), *(++it2));
+    while (++it1 != last1) {
+        auto value = op(*it1, *(++it2));
         if (largest_value < value) {
             largest1 = it1;
             largest_value = value;
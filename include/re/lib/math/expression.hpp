@@ -0,0 +1,390 @@
+#pragma once
+
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/math/element.hpp>
+#include <re/lib/math/reductions.hpp>
+#include <re/lib/simd/simd.hpp>
+
+// Lazy element-wise arithmetic over spans. Expressions are built from
+// lazy(span) and scalars with the usual operators and the functions below,
+// and are only evaluated when assigned to a span or reduced, in a single
+// loop over lanes however long the chain is:
+//
+//     assign(out, clamp(lazy(in) * gain - lazy(floor), 0.f, 1.f));
+//     auto energy = sum(max(lazy(in), 0.f));
+
+namespace re {
+namespace math
+{
+using namespace simd;
+
+template <typename E>
+struct is_expression : std::false_type {};
+
+template <typename T>
+class span_expression
+{
+public:
+    using value_type = T;
+
+    explicit span_expression(gsl::span<T const> in)
+    noexcept :
+        p(in.data()),
+        n(std::size(in))
+    {
+    }
+
+    int_t size()
+    const noexcept {
+        return n;
+    }
+
+    lane<T> lane_at(int_t i)
+    const {
+        return load(p + i);
+    }
+
+    T at(int_t i)
+    const {
+        return p[i];
+    }
+
+private:
+    T const* p;
+    int_t n;
+};
+
+// A value repeated to whatever length the rest of the expression has.
+template <typename T>
+class scalar_expression
+{
+public:
+    using value_type = T;
+
+    explicit scalar_expression(T value)
+    noexcept :
+        value(value)
+    {
+    }
+
+    int_t size()
+    const noexcept {
+        return -1;
+    }
+
+    lane<T> lane_at(int_t)
+    const {
+        return set_lane(value);
+    }
+
+    T at(int_t)
+    const {
+        return value;
+    }
+
+private:
+    T value;
+};
+
+template <typename Op, typename... Es>
+class expression
+{
+    using indices = std::index_sequence_for<Es...>;
+
+public:
+    using value_type = typename std::tuple_element_t<
+        0,
+        std::tuple<Es...>
+    >::value_type;
+
+    static_assert(
+        std::conjunction<std::is_same<value_type, typename Es::value_type>...>::value,
+        "operands must share their value type"
+    );
+
+    explicit expression(Es const&... operands)
+    noexcept :
+        operands(operands...),
+        n(std::max({operands.size()...}))
+    {
+        assert(((operands.size() < 0 || operands.size() == n) && ...));
+    }
+
+    int_t size()
+    const noexcept {
+        return n;
+    }
+
+    lane<value_type> lane_at(int_t i)
+    const {
+        return lane_at(i, indices{});
+    }
+
+    value_type at(int_t i)
+    const {
+        return at(i, indices{});
+    }
+
+private:
+    template <std::size_t... I>
+    lane<value_type> lane_at(int_t i, std::index_sequence<I...>)
+    const {
+        return Op()(std::get<I>(operands).lane_at(i)...);
+    }
+
+    template <std::size_t... I>
+    value_type at(int_t i, std::index_sequence<I...>)
+    const {
+        return Op()(std::get<I>(operands).at(i)...);
+    }
+
+    std::tuple<Es...> operands;
+    int_t n;
+};
+
+template <typename T>
+struct is_expression<span_expression<T>> : std::true_type {};
+
+template <typename T>
+struct is_expression<scalar_expression<T>> : std::true_type {};
+
+template <typename Op, typename... Es>
+struct is_expression<expression<Op, Es...>> : std::true_type {};
+
+template <typename T, int_t N>
+span_expression<std::remove_const_t<T>> lazy(gsl::span<T, N> in)
+noexcept {
+    return span_expression<std::remove_const_t<T>>(in);
+}
+
+// Operands are expressions or scalars of their value type, at least one of
+// them an expression.
+template <typename A, typename... As>
+struct first_expression
+{
+    using type = std::conditional_t<
+        is_expression<A>::value,
+        A,
+        typename first_expression<As...>::type
+    >;
+};
+
+template <typename A>
+struct first_expression<A> { using type = A; };
+
+template <typename... As>
+using enable_if_operands_t = std::enable_if_t<
+    std::disjunction<is_expression<As>...>::value,
+    typename first_expression<As...>::type::value_type
+>;
+
+template <typename T, typename E>
+E const& operand(E const& e, std::enable_if_t<is_expression<E>::value>* = nullptr)
+noexcept {
+    return e;
+}
+
+template <typename T>
+scalar_expression<T> operand(T value)
+noexcept {
+    return scalar_expression<T>(value);
+}
+
+template <
+    template <typename> class Op,
+    typename... As,
+    typename T = enable_if_operands_t<As...>
+>
+auto make_expression(As const&... operands) {
+    return expression<Op<T>, std::decay_t<decltype(operand<T>(operands))>...>(
+        operand<T>(operands)...
+    );
+}
+
+template <typename T> struct fdim_op {
+    T operator()(T a, T b) { return std::fdim(a, b); }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return intrinsics::max<T>()(subtract(a, b), intrinsics::zero<T>());
+    }
+};
+
+template <typename T> struct clamp_op {
+    T operator()(T x, T lo, T hi) { return std::min(std::max(x, lo), hi); }
+    lane<T> operator()(lane<T> x, lane<T> lo, lane<T> hi) {
+        return intrinsics::min<T>()(intrinsics::max<T>()(x, lo), hi);
+    }
+};
+
+template <typename T> struct negate_op {
+    T operator()(T a) { return -a; }
+    lane<T> operator()(lane<T> a) {
+        return subtract(intrinsics::zero<T>(), a);
+    }
+};
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto operator+(A const& a, B const& b) {
+    return make_expression<intrinsics::add>(a, b);
+}
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto operator-(A const& a, B const& b) {
+    return make_expression<intrinsics::sub>(a, b);
+}
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto operator*(A const& a, B const& b) {
+    return make_expression<intrinsics::mul>(a, b);
+}
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto operator/(A const& a, B const& b) {
+    return make_expression<intrinsics::div>(a, b);
+}
+
+template <typename A, typename = enable_if_operands_t<A>>
+auto operator-(A const& a) {
+    return make_expression<negate_op>(a);
+}
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto max(A const& a, B const& b) {
+    return make_expression<intrinsics::max>(a, b);
+}
+
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto min(A const& a, B const& b) {
+    return make_expression<intrinsics::min>(a, b);
+}
+
+// Positive difference, max(a - b, 0).
+template <typename A, typename B, typename = enable_if_operands_t<A, B>>
+auto fdim(A const& a, B const& b) {
+    return make_expression<fdim_op>(a, b);
+}
+
+template <
+    typename A,
+    typename Lo,
+    typename Hi,
+    typename = enable_if_operands_t<A, Lo, Hi>
+>
+auto clamp(A const& a, Lo const& lo, Hi const& hi) {
+    return make_expression<clamp_op>(a, lo, hi);
+}
+
+template <typename A, typename = enable_if_operands_t<A>>
+auto sqrt(A const& a) {
+    return make_expression<intrinsics::sqrt>(a);
+}
+
+// Evaluates the expression into out, one lane at a time. out may be one of
+// the spans the expression reads.
+template <
+    typename T,
+    int_t N,
+    typename E,
+    typename = std::enable_if_t<is_expression<E>::value>
+>
+void assign(gsl::span<T, N> out, E const& e) {
+    static_assert(std::is_same<T, typename E::value_type>::value);
+    auto const n = static_cast<int_t>(std::size(out));
+    assert(e.size() < 0 || e.size() == n);
+
+    auto const p = out.data();
+    int_t i = 0;
+    for (; i + width<T> <= n; i += width<T>) {
+        store(p + i, e.lane_at(i));
+    }
+    // Counted separately, so that the compiler does not take i for an
+    // index that could run past the end.
+    auto const rest = n - i;
+    for (int_t j = 0; j < rest; ++j) {
+        p[i + j] = e.at(i + j);
+    }
+}
+
+// Folds the expression with op into Accumulators independent lanes, like
+// reduce over a span.
+template <
+    uint_t Accumulators = accumulators,
+    typename E,
+    typename T = typename E::value_type,
+    typename BinaryOp,
+    typename = std::enable_if_t<is_expression<E>::value>
+>
+T reduce(E const& e, lane<T> initial, BinaryOp op) {
+    auto const n = e.size();
+    assert(n >= 0);
+    constexpr auto step = static_cast<int_t>(Accumulators) * width<T>;
+
+    std::array<lane<T>, Accumulators> partial;
+    partial.fill(initial);
+
+    int_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (auto k = 0u; k < Accumulators; ++k) {
+            partial[k] = op(partial[k], e.lane_at(i + k * width<T>));
+        }
+    }
+    for (; i + width<T> <= n; i += width<T>) {
+        partial[0] = op(partial[0], e.lane_at(i));
+    }
+    for (; i < n; ++i) {
+        partial[0].a[0] = op(partial[0].a[0], e.at(i));
+    }
+
+    typename reduction_of<BinaryOp>::type merge;
+    for (auto stride = 1u; stride < Accumulators; stride *= 2) {
+        for (auto k = 0u; k + stride < Accumulators; k += 2*stride) {
+            partial[k] = merge(partial[k], partial[k + stride]);
+        }
+    }
+    return op << partial[0];
+}
+
+template <
+    uint_t Accumulators = accumulators,
+    typename E,
+    typename = std::enable_if_t<is_expression<E>::value>
+>
+auto sum(E const& e) {
+    using T = typename E::value_type;
+    return reduce<Accumulators>(e, intrinsics::zero<T>(), intrinsics::add<T>());
+}
+
+// First largest element of the expression along with its position.
+template <typename E, typename = std::enable_if_t<is_expression<E>::value>>
+auto max(E const& e) {
+    using T = typename E::value_type;
+    return arg_reduce<T>(
+        e.size(),
+        intrinsics::greater<T>(),
+        [&e] (int_t i) { return e.lane_at(i); },
+        [&e] (int_t i) { return e.at(i); }
+    );
+}
+
+// First smallest element of the expression along with its position.
+template <typename E, typename = std::enable_if_t<is_expression<E>::value>>
+auto min(E const& e) {
+    using T = typename E::value_type;
+    return arg_reduce<T>(
+        e.size(),
+        intrinsics::less<T>(),
+        [&e] (int_t i) { return e.lane_at(i); },
+        [&e] (int_t i) { return e.at(i); }
+    );
+}
+
+}
+}
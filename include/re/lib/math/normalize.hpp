@@ -1,37 +1,46 @@
 #pragma once
 
 #include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <type_traits>
+
 #include <gsl/span>
-#include <numeric>
 
 #include <re/lib/common.hpp>
+#include <re/lib/math/expression.hpp>
+#include <re/lib/math/reductions.hpp>
+#include <re/lib/simd/simd.hpp>
+#include <re/lib/simd/transcendental.hpp>
+
+// Normalizations of spectra and other frames. Each takes one vectorized
+// pass to find the norm and another to multiply by its reciprocal. A norm
+// of zero leaves the values as they are, so a silent frame stays silent
+// instead of turning into NaN. in and out may be the same span.
 
 namespace re {
 namespace math {
 
+// out = in / norm, or in itself if norm is zero.
 template <typename T, int_t N_in, int_t N_out>
 void
-normalize(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+scale_by_inverse(gsl::span<T const, N_in> in, gsl::span<T, N_out> out, T norm)
 noexcept {
     assert(std::size(in) == std::size(out));
-    auto sum = std::accumulate(
-        std::cbegin(in),
-        std::cend(in),
-        static_cast<T>(0),
-        [] (const auto result, const auto value) {
-            return result + std::fmax(value, 0);
-        }
-    );
+    if (norm > 0) {
+        assign(out, lazy(in) * (1 / norm));
+    } else if (in.data() != out.data()) {
+        std::copy(std::cbegin(in), std::cend(in), std::begin(out));
+    }
+}
 
-    assert(sum >= 0);
-    std::transform(
-        std::cbegin(in),
-        std::cend(in),
-        std::begin(out),
-        [sum] (auto v) {
-            return v / sum;
-        }
-    );
+// Divides by the sum of the positive values.
+template <typename T, int_t N_in, int_t N_out>
+void
+normalize(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+noexcept {
+    scale_by_inverse(in, out, sum(max(lazy(in), T{0})));
 }
 
 template <typename T, int_t N>
@@ -41,5 +50,161 @@ noexcept {
     normalize(gsl::span<T const, N>(data), data);
 }
 
+// Divides by the square root of the sum of squares.
+template <typename T, int_t N_in, int_t N_out>
+void
+normalize_l2(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+noexcept {
+    scale_by_inverse(in, out, std::sqrt(sum_of_squares(in)));
+}
+
+template <typename T, int_t N>
+void
+normalize_l2(gsl::span<T, N> data)
+noexcept {
+    normalize_l2(gsl::span<T const, N>(data), data);
+}
+
+// Divides by the largest magnitude.
+template <typename T, int_t N_in, int_t N_out>
+void
+normalize_max(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+noexcept {
+    scale_by_inverse(
+        in,
+        out,
+        reduce(
+            max(lazy(in), -lazy(in)),
+            intrinsics::zero<T>(),
+            intrinsics::max<T>()
+        )
+    );
+}
+
+template <typename T, int_t N>
+void
+normalize_max(gsl::span<T, N> data)
+noexcept {
+    normalize_max(gsl::span<T const, N>(data), data);
+}
+
+// Subtracts the mean and divides by the standard deviation of the
+// population. The sums are taken around the first value, as in
+// correlation, so that a large mean does not cancel out the variance.
+template <typename T, int_t N_in, int_t N_out>
+void
+standardize(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+noexcept {
+    assert(std::size(in) == std::size(out));
+    if (std::size(in) == 0) {
+        return;
+    }
+
+    auto const x0 = in[0];
+    auto const shift = set_lane(x0);
+    auto const sums = fused_sums<2>(
+        [&] (auto& sums, auto x) {
+            using U = decltype(x);
+            U d;
+            if constexpr (std::is_same<U, T>::value) {
+                d = x - x0;
+            } else {
+                d = subtract(x, shift);
+            }
+            sums[0] = intrinsics::add<T>()(sums[0], d);
+            sums[1] = intrinsics::mul_add<T>()(d, d, sums[1]);
+        },
+        in
+    );
+
+    auto const n = static_cast<T>(std::size(in));
+    auto const mean = sums[0] / n;
+    auto const variance = std::max(sums[1] / n - mean * mean, T{0});
+    auto const deviation = std::sqrt(variance);
+    auto const centred = lazy(in) - (x0 + mean);
+    if (deviation > 0) {
+        assign(out, centred * (1 / deviation));
+    } else {
+        assign(out, centred);
+    }
+}
+
+template <typename T, int_t N>
+void
+standardize(gsl::span<T, N> data)
+noexcept {
+    standardize(gsl::span<T const, N>(data), data);
+}
+
+// e^in[i] over the sum of them all. The exponentials are taken of the
+// values less the largest, which keeps them from overflowing and the sum
+// at least 1.
+template <typename T, int_t N_in, int_t N_out>
+void
+softmax(gsl::span<T const, N_in> in, gsl::span<T, N_out> out)
+noexcept {
+    assert(std::size(in) == std::size(out));
+    auto const n = std::size(in);
+    if (n == 0) {
+        return;
+    }
+
+    auto const top = reduce(in, set_lane(in[0]), intrinsics::max<T>());
+    auto const shift = set_lane(top);
+    auto total = intrinsics::zero<T>();
+    T rest = 0;
+    int_t i = 0;
+    for (; i + width<T> <= n; i += width<T>) {
+        auto const e = simd::exp(subtract(load(in.data() + i), shift));
+        store(out.data() + i, e);
+        total = add(total, e);
+    }
+    auto const tail = n - i;
+    for (int_t j = 0; j < tail; ++j) {
+        out[i + j] = std::exp(in[i + j] - top);
+        rest += out[i + j];
+    }
+
+    auto const sum = rest + (intrinsics::add<T>() << total);
+    assign(out, lazy(gsl::span<T const, N_out>(out)) * (1 / sum));
+}
+
+template <typename T, int_t N>
+void
+softmax(gsl::span<T, N> data)
+noexcept {
+    softmax(gsl::span<T const, N>(data), data);
+}
+
+// Normalizes every row of a matrix of frames stored one after another,
+// columns values each, by calling fn(row_in, row_out) on dynamic spans:
+//
+//     normalize_rows(in, out, bins, [] (auto row_in, auto row_out) {
+//         softmax(row_in, row_out);
+//     });
+template <typename T, int_t N_in, int_t N_out, typename Fn>
+void
+normalize_rows(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    int_t columns,
+    Fn fn
+) {
+    assert(std::size(in) == std::size(out));
+    assert(columns > 0 && std::size(in) % columns == 0);
+    for (int_t row = 0; row < std::size(in); row += columns) {
+        fn(
+            gsl::span<T const>(in.data() + row, columns),
+            gsl::span<T>(out.data() + row, columns)
+        );
+    }
+}
+
+template <typename T, int_t N, typename Fn>
+void
+normalize_rows(gsl::span<T, N> data, int_t columns, Fn fn) {
+    normalize_rows(gsl::span<T const, N>(data), data, columns, fn);
+}
+
 }
 }
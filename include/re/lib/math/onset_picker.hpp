@@ -0,0 +1,208 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+#include <re/lib/common.hpp>
+#include <re/lib/container/dynamic_ring.hpp>
+#include <re/lib/container/sliding_aggregate.hpp>
+#include <re/lib/container/sliding_percentile.hpp>
+#include <re/lib/math/peaks.hpp>
+
+namespace re {
+namespace math {
+
+// Windows of the frames around a candidate, in frames on either side of
+// it, and the rules a peak must pass.
+template <typename T>
+struct peak_picking {
+    // It is the largest value from pre_max before to post_max after.
+    int_t pre_max = 3;
+    int_t post_max = 1;
+    // It exceeds the mean (or median) from pre_average before to
+    // post_average after by at least delta.
+    int_t pre_average = 10;
+    int_t post_average = 1;
+    T delta = 0;
+    // It comes more than wait frames after the previous onset.
+    int_t wait = 3;
+};
+
+// Mean of the last length values, counting zeros before the first. The
+// running sum is compensated, as in sliding_aggregate, so it does not
+// drift over a long stream.
+template <typename T>
+class window_mean {
+public:
+    explicit window_mean(std::size_t length) :
+        history(length, T{0}),
+        n(static_cast<T>(length))
+    {
+        assert(length > 0);
+    }
+
+    void push_back(T value)
+    noexcept {
+        add(-history.front());
+        add(value);
+        history.push_back(value);
+    }
+
+    T value()
+    const noexcept {
+        return (total + compensation) / n;
+    }
+
+private:
+    void add(T value)
+    noexcept {
+        auto const t = total + value;
+        if (std::abs(total) >= std::abs(value)) {
+            compensation += (total - t) + value;
+        } else {
+            compensation += (value - t) + total;
+        }
+        total = t;
+    }
+
+    dynamic_ring<T> history;
+    T n;
+    T total = 0;
+    T compensation = 0;
+};
+
+// Median of the last length values, counting zeros before the first.
+template <typename T>
+class window_median : public sliding_percentile<T> {
+public:
+    explicit window_median(std::size_t length) :
+        sliding_percentile<T>(length, percentile_rank(length, 0.5))
+    {
+    }
+};
+
+template <typename T>
+struct onset {
+    std::uint64_t frame;
+    // Offset of the vertex through the peak and its neighbours from the
+    // frame, within [-0.5, 0.5], and its height.
+    T offset;
+    T strength;
+
+    double position()
+    const noexcept {
+        return static_cast<double>(frame) + offset;
+    }
+};
+
+// Picks onsets from an onset detection function one frame at a time.
+// The decision on a frame waits for latency() more, the longer of the
+// windows after it and at least the one frame the vertex needs, so a
+// push of frame t answers for frame t - latency(). Values before the
+// stream count as zeros, which onset functions never go below.
+//
+// The maximum comes from a monotonic queue and the mean from a running
+// sum, so a frame costs O(1) amortized; Window = window_median instead
+// costs O(log) of the average window.
+template <typename T, typename Window = window_mean<T>>
+class onset_picker {
+public:
+    explicit onset_picker(peak_picking<T> const& settings) :
+        settings(settings),
+        lag(std::max({settings.post_max, settings.post_average, int_t{1}})),
+        history(static_cast<std::size_t>(lag + 2)),
+        highest(static_cast<std::size_t>(
+            settings.pre_max + settings.post_max + 2
+        )),
+        average(static_cast<std::size_t>(
+            settings.pre_average + settings.post_average + 1
+        ))
+    {
+        assert(settings.pre_max >= 0 && settings.post_max >= 0);
+        assert(settings.pre_average >= 0 && settings.post_average >= 0);
+        assert(settings.wait >= 0);
+        // Stands for all the zeros before the stream, queue positions
+        // being frames plus one.
+        highest.push(0, T{0});
+    }
+
+    int_t latency()
+    const noexcept {
+        return lag;
+    }
+
+    // Frames pushed so far.
+    std::uint64_t size()
+    const noexcept {
+        return pushed;
+    }
+
+    std::optional<onset<T>> push(T value)
+    noexcept {
+        history.push_back(value);
+        auto const t = static_cast<std::int64_t>(pushed++);
+        auto const n = t - lag;
+
+        // The windows of frame n end post_max and post_average after it.
+        auto const max_end = n + settings.post_max;
+        if (max_end >= 0) {
+            auto const start = n - settings.pre_max;
+            if (start >= 0) {
+                highest.expire(static_cast<std::uint64_t>(start + 1));
+            }
+            highest.push(
+                static_cast<std::uint64_t>(max_end + 1),
+                at(max_end)
+            );
+        }
+        auto const average_end = n + settings.post_average;
+        if (average_end >= 0) {
+            average.push_back(at(average_end));
+        }
+        if (n < 0) {
+            return std::nullopt;
+        }
+
+        auto const x = at(n);
+        if (x < highest.front()
+            || x < average.value() + settings.delta
+            || (picked && n - last <= settings.wait)) {
+            return std::nullopt;
+        }
+
+        picked = true;
+        last = n;
+        auto const vertex = parabolic_vertex()(at(n - 1), x, at(n + 1));
+        return onset<T>{
+            static_cast<std::uint64_t>(n),
+            vertex.first,
+            vertex.second
+        };
+    }
+
+private:
+    // The value of frame i, at most lag + 1 frames back.
+    T at(std::int64_t i)
+    const noexcept {
+        auto const back = static_cast<std::int64_t>(pushed) - 1 - i;
+        assert(back >= 0 && back < static_cast<std::int64_t>(history.size()));
+        return history[history.size() - 1 - static_cast<std::size_t>(back)];
+    }
+
+    peak_picking<T> settings;
+    int_t lag;
+    dynamic_ring<T> history;
+    monotonic_queue<T, std::greater<T>> highest;
+    Window average;
+    std::uint64_t pushed = 0;
+    std::int64_t last = 0;
+    bool picked = false;
+};
+
+}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/simd/aligned.hpp>
+#include <re/lib/simd/simd.hpp>
+
+// Integer PCM to the floating point spans the rest of the library works on.
+// Full scale maps to [-1, 1), times an optional gain. Interleaved frames are
+// split into one span per channel or downmixed to a single one on the way,
+// so the output can go straight into a ring_array or an STFT frame.
+
+namespace re {
+namespace math {
+
+using namespace simd;
+
+// 24 bit little endian sample as packed in a byte stream.
+struct packed_int24
+{
+    std::uint8_t bytes[3];
+};
+static_assert(sizeof(packed_int24) == 3);
+
+// Magnitude of full scale of a sample as widened by sample_value.
+template <typename S> struct pcm_traits;
+
+template <>
+struct pcm_traits<std::int16_t> {
+    static constexpr double full_scale = 0x1p15;
+};
+
+template <>
+struct pcm_traits<std::int32_t> {
+    static constexpr double full_scale = 0x1p31;
+};
+
+// 24 bit samples are widened into the upper bytes of a 32 bit word.
+template <>
+struct pcm_traits<packed_int24> {
+    static constexpr double full_scale = 0x1p31;
+};
+
+inline std::int32_t left_justified(packed_int24 s)
+noexcept {
+    return static_cast<std::int32_t>(
+        std::uint32_t{s.bytes[0]} << 8
+        | std::uint32_t{s.bytes[1]} << 16
+        | std::uint32_t{s.bytes[2]} << 24
+    );
+}
+
+template <typename T>
+T sample_value(std::int16_t s)
+noexcept {
+    return static_cast<T>(s);
+}
+
+template <typename T>
+T sample_value(std::int32_t s)
+noexcept {
+    return static_cast<T>(s);
+}
+
+template <typename T>
+T sample_value(packed_int24 s)
+noexcept {
+    return static_cast<T>(left_justified(s));
+}
+
+template <typename T>
+lane<T> load_samples(std::int16_t const* p) {
+    return load_converted<T>(p);
+}
+
+template <typename T>
+lane<T> load_samples(std::int32_t const* p) {
+    return load_converted<T>(p);
+}
+
+// There is no byte shuffle in every backend, so 24 bit words are assembled
+// one by one and only the conversion is vectorized.
+template <typename T>
+lane<T> load_samples(packed_int24 const* p) {
+    std::array<std::int32_t, width<T>> words;
+    for (auto i = 0; i < width<T>; ++i) {
+        words[i] = left_justified(p[i]);
+    }
+    return load_converted<T>(words.data());
+}
+
+template <typename S, typename T>
+void convert_samples(S const* in, T* out, int_t n, T scale) {
+    auto const factor = set_lane(scale);
+    int_t i = 0;
+    for (; i + width<T> <= n; i += width<T>) {
+        store(out + i, multiply(load_samples<T>(in + i), factor));
+    }
+    for (; i < n; ++i) {
+        out[i] = scale * sample_value<T>(in[i]);
+    }
+}
+
+// Frames split at once, few enough for the planes to stay in cache.
+constexpr int_t pcm_block_frames = 128;
+
+// Converts interleaved frames into planes one channel at a time. With the
+// channel count a constant the compiler turns the strided reads into
+// shuffles, which beats converting whole lanes and transposing them after.
+template <std::size_t Channels, typename S, typename T>
+void split_frames(
+    S const* in,
+    int_t frames,
+    T scale,
+    std::array<T*, Channels> const& planes
+) {
+    if constexpr (Channels == 1) {
+        convert_samples(in, planes[0], frames, scale);
+    } else {
+        for (auto c = 0u; c < Channels; ++c) {
+            auto const plane = planes[c];
+            for (int_t f = 0; f < frames; ++f) {
+                plane[f] = scale * sample_value<T>(in[f * int_t{Channels} + c]);
+            }
+        }
+    }
+}
+
+template <typename S, typename T, int_t N, int_t M>
+void convert(gsl::span<S const, N> in, gsl::span<T, M> out, T gain = 1)
+noexcept {
+    assert(std::size(in) == std::size(out));
+    convert_samples(
+        in.data(),
+        out.data(),
+        static_cast<int_t>(std::size(in)),
+        static_cast<T>(gain / pcm_traits<S>::full_scale)
+    );
+}
+
+// Splits interleaved frames into one span per channel.
+template <std::size_t Channels, typename S, typename T, int_t N, int_t M>
+void deinterleave(
+    gsl::span<S const, N> in,
+    std::array<gsl::span<T, M>, Channels> const& out,
+    T gain = 1
+) noexcept {
+    static_assert(Channels > 0);
+    auto const frames = static_cast<int_t>(std::size(in)) / int_t{Channels};
+    assert(std::size(in) == frames * int_t{Channels});
+    assert(std::all_of(
+        std::cbegin(out),
+        std::cend(out),
+        [frames] (auto const& channel) { return std::size(channel) == frames; }
+    ));
+
+    auto const scale = static_cast<T>(gain / pcm_traits<S>::full_scale);
+    for (int_t f = 0; f < frames; f += pcm_block_frames) {
+        std::array<T*, Channels> planes;
+        for (auto c = 0u; c < Channels; ++c) {
+            planes[c] = out[c].data() + f;
+        }
+        split_frames<Channels>(
+            in.data() + f * int_t{Channels},
+            std::min(pcm_block_frames, frames - f),
+            scale,
+            planes
+        );
+    }
+}
+
+// Weighted sum of the channels of interleaved frames, one value per frame.
+template <std::size_t Channels, typename S, typename T, int_t N, int_t M>
+void downmix(
+    gsl::span<S const, N> in,
+    std::array<T, Channels> const& weights,
+    gsl::span<T, M> out
+) noexcept {
+    static_assert(Channels > 0);
+    auto const frames = static_cast<int_t>(std::size(out));
+    assert(std::size(in) == frames * int_t{Channels});
+
+    auto const scale = static_cast<T>(1 / pcm_traits<S>::full_scale);
+    std::array<lane<T>, Channels> w;
+    for (auto c = 0u; c < Channels; ++c) {
+        w[c] = set_lane(weights[c]);
+    }
+
+    aligned_array<T, Channels * pcm_block_frames> planar;
+    std::array<T*, Channels> planes;
+    for (auto c = 0u; c < Channels; ++c) {
+        planes[c] = planar.data() + c * pcm_block_frames;
+    }
+
+    for (int_t f = 0; f < frames; f += pcm_block_frames) {
+        auto const block = std::min(pcm_block_frames, frames - f);
+        split_frames<Channels>(
+            in.data() + f * int_t{Channels},
+            block,
+            scale,
+            planes
+        );
+
+        auto const p = out.data() + f;
+        int_t i = 0;
+        for (; i + width<T> <= block; i += width<T>) {
+            auto sum = multiply(load_aligned(planes[0] + i), w[0]);
+            for (auto c = 1u; c < Channels; ++c) {
+                sum = intrinsics::mul_add<T>()(
+                    load_aligned(planes[c] + i),
+                    w[c],
+                    sum
+                );
+            }
+            store(p + i, sum);
+        }
+        for (; i < block; ++i) {
+            auto sum = planes[0][i] * weights[0];
+            for (auto c = 1u; c < Channels; ++c) {
+                sum += planes[c][i] * weights[c];
+            }
+            p[i] = sum;
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/math/element.hpp>
+#include <re/lib/simd/simd.hpp>
+
+namespace re {
+namespace math {
+
+// Vertex of the parabola through three equally spaced points, as its
+// offset from the middle one, within [-0.5, 0.5] when that is the
+// largest, and its height.
+struct parabolic_vertex {
+    template <typename T>
+    std::pair<T, T> operator()(T left, T centre, T right)
+    const noexcept {
+        auto const curvature = left - 2 * centre + right;
+        if (curvature == 0) {
+            return {T{0}, centre};
+        }
+        auto const offset = T{0.5} * (left - right) / curvature;
+        return {offset, centre - T{0.25} * (left - right) * offset};
+    }
+};
+
+// The same for a Gaussian, a parabola through the logarithms, which fits
+// the main lobe of a Gaussian window exactly. The points must be positive.
+struct gaussian_vertex {
+    template <typename T>
+    std::pair<T, T> operator()(T left, T centre, T right)
+    const noexcept {
+        assert(left > 0 && centre > 0 && right > 0);
+        auto const vertex = parabolic_vertex()(
+            std::log(left),
+            std::log(centre),
+            std::log(right)
+        );
+        return {vertex.first, std::exp(vertex.second)};
+    }
+};
+
+// The sample itself.
+struct nearest_sample {
+    template <typename T>
+    std::pair<T, T> operator()(T, T centre, T)
+    const noexcept {
+        return {T{0}, centre};
+    }
+};
+
+// Up to K peaks, strongest first. Each is an element with the index of
+// its sample and its interpolated height, along with its interpolated
+// position.
+template <typename T, std::size_t K>
+class peak_list {
+public:
+    using value_type = element<T>;
+    using const_iterator = typename std::array<element<T>, K>::const_iterator;
+
+    std::size_t size()
+    const noexcept {
+        return count;
+    }
+
+    static constexpr std::size_t capacity()
+    noexcept {
+        return K;
+    }
+
+    bool empty()
+    const noexcept {
+        return count == 0;
+    }
+
+    element<T> const& operator[](std::size_t i)
+    const noexcept {
+        assert(i < count);
+        return peaks[i];
+    }
+
+    // The index of the i-th peak plus the offset of the vertex.
+    T position(std::size_t i)
+    const noexcept {
+        assert(i < count);
+        return positions[i];
+    }
+
+    const_iterator begin() const noexcept { return std::cbegin(peaks); }
+    const_iterator end() const noexcept { return std::cbegin(peaks) + count; }
+
+    void push_back(element<T> const& peak, T position)
+    noexcept {
+        assert(count < K);
+        peaks[count] = peak;
+        positions[count] = position;
+        ++count;
+    }
+
+private:
+    std::array<element<T>, K> peaks;
+    std::array<T, K> positions;
+    std::size_t count = 0;
+};
+
+// The K highest local maxima of in, found in one vectorized pass and
+// kept in a bounded heap, so nothing is allocated. A local maximum is
+// higher than the distance - 1 values before it and at least as high as
+// the distance - 1 values after it, so of two maxima closer than distance
+// only the higher survives, and of a plateau only its first sample.
+// The first and last values have a side missing and are never peaks.
+// Equal peaks rank in the order they come.
+//
+// The heights pick the peaks; refine then fits a vertex to each and its
+// two neighbours. The list keeps the order of the sample heights.
+template <
+    std::size_t K,
+    typename Refine = parabolic_vertex,
+    typename T,
+    int_t N
+>
+peak_list<T, K> find_peaks(
+    gsl::span<T const, N> in,
+    int_t distance = 1,
+    Refine refine = Refine()
+) {
+    static_assert(K > 0);
+    assert(distance >= 1);
+    constexpr auto width = simd::width<T>;
+    auto const n = static_cast<int_t>(std::size(in));
+    auto const p = in.data();
+    auto const reach = distance - 1;
+
+    auto const ranks_before = [] (element<T> const& a, element<T> const& b) {
+        return a.value > b.value || (a.value == b.value && a.index < b.index);
+    };
+
+    // The heap keeps the weakest of the peaks so far at the front, and
+    // once full only a higher value can get in.
+    std::array<element<T>, K> heap;
+    std::size_t count = 0;
+    auto floor = -std::numeric_limits<T>::infinity();
+    auto const offer = [&] (int_t i) {
+        element<T> const peak(p[i], static_cast<std::size_t>(i));
+        if (count < K) {
+            heap[count++] = peak;
+            std::push_heap(
+                std::begin(heap),
+                std::begin(heap) + count,
+                ranks_before
+            );
+        } else if (ranks_before(peak, heap[0])) {
+            std::pop_heap(std::begin(heap), std::end(heap), ranks_before);
+            heap[K - 1] = peak;
+            std::push_heap(std::begin(heap), std::end(heap), ranks_before);
+        } else {
+            return;
+        }
+        if (count == K) {
+            floor = heap[0].value;
+        }
+    };
+
+    auto const is_peak = [&] (int_t i) {
+        for (int_t k = 1; k <= std::max(reach, int_t{1}); ++k) {
+            if ((i - k >= 0 && p[i - k] >= p[i])
+                || (i + k < n && p[i + k] > p[i])) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Vectors from the first sample whose whole neighbourhood is in.
+    auto const margin = std::max(reach, int_t{1});
+    int_t i = 1;
+    for (; i < std::min(margin, n - 1); ++i) {
+        if (p[i] > floor && is_peak(i)) {
+            offer(i);
+        }
+    }
+
+    simd::intrinsics::max<T> max;
+    simd::intrinsics::min<T> min;
+    simd::intrinsics::less<T> less;
+    simd::intrinsics::select<T> select;
+    simd::intrinsics::any_greater_than<T> any_greater_than;
+    auto const zero = simd::intrinsics::zero<T>();
+    auto const reject = simd::set_lane(T{-1});
+    for (; i + width + margin <= n; i += width) {
+        auto const x = simd::load(p + i);
+        auto const above = simd::set_lane(floor);
+        if (!any_greater_than(x, above)) {
+            continue;
+        }
+
+        auto left = simd::load(p + i - 1);
+        auto right = simd::load(p + i + 1);
+        for (int_t k = 2; k <= reach; ++k) {
+            left = max(left, simd::load(p + i - k));
+            right = max(right, simd::load(p + i + k));
+        }
+
+        // Positive where x rises above the left, the floor and holds
+        // against the right.
+        auto keep = select(
+            less(x, right),
+            reject,
+            simd::subtract(x, left)
+        );
+        keep = min(keep, simd::subtract(x, above));
+        if (!any_greater_than(keep, zero)) {
+            continue;
+        }
+        for (int_t j = 0; j < width; ++j) {
+            if (keep.a[j] > 0 && p[i + j] > floor) {
+                offer(i + j);
+            }
+        }
+    }
+    for (; i < n - 1; ++i) {
+        if (p[i] > floor && is_peak(i)) {
+            offer(i);
+        }
+    }
+
+    std::sort_heap(std::begin(heap), std::begin(heap) + count, ranks_before);
+    peak_list<T, K> list;
+    for (std::size_t k = 0; k < count; ++k) {
+        auto const at = static_cast<int_t>(heap[k].index);
+        auto const vertex = refine(p[at - 1], p[at], p[at + 1]);
+        list.push_back(
+            element<T>(vertex.second, heap[k].index),
+            static_cast<T>(at) + vertex.first
+        );
+    }
+    return list;
+}
+
+}
+}
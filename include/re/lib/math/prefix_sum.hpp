@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cassert>
+#include <gsl/span>
+
+#include <re/lib/common.hpp>
+#include <re/lib/simd/simd.hpp>
+
+namespace re {
+namespace math {
+
+// Running sums, out[i] = initial + in[0] + ... + in[i]. Each lane is
+// scanned in registers and offset by the total of the lanes before it.
+// in and out may be the same span. Returns the total.
+template <typename T, int_t N_in, int_t N_out>
+T
+prefix_sum(
+    gsl::span<T const, N_in> in,
+    gsl::span<T, N_out> out,
+    T initial = 0
+) noexcept {
+    assert(std::size(in) == std::size(out));
+    constexpr auto width = simd::width<T>;
+    auto const n = std::size(in);
+
+    simd::intrinsics::prefix_sum<T> scan;
+    auto total = initial;
+    int_t i = 0;
+    for (; i + width <= n; i += width) {
+        auto const x = simd::add(
+            scan(simd::load(in.data() + i)),
+            simd::set_lane(total)
+        );
+        simd::store(out.data() + i, x);
+        total = x.a[width - 1];
+    }
+    for (; i < n; ++i) {
+        total += in[i];
+        out[i] = total;
+    }
+    return total;
+}
+
+}
+}
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <limits>
 #include <gsl/span>
 
 #include <re/lib/common.hpp>
+#include <re/lib/math/element.hpp>
 #include <re/lib/simd/simd.hpp>
+#include <re/lib/simd/simd_memory_iterator.hpp>
 
 namespace re {
 namespace math
@@ -14,51 +21,291 @@ namespace math
 using namespace simd;
 
 
-template <typename T, int_t N, typename BinaryOp>
-T reduce(gsl::span<T const, N> in, lane<T> result, BinaryOp op) {
-    auto it = std::cbegin(in);
-    for (auto i = 0u; i < (in.size() % width<T>); ++i) {
-        result.a[i] = op(result.a[i], *it);
-    }
-    for (; it < std::cend(in); it += width<T>) {
-        result = op(result, load(&(*it)));
+// Folds the span with op into Accumulators independent lanes, merging them
+// at the end. Every accumulator starts from `initial`, so its elements should
+// be neutral to op.
+template <
+    uint_t Accumulators = accumulators,
+    typename T,
+    int_t N,
+    typename BinaryOp
+>
+T reduce(gsl::span<T const, N> in, lane<T> initial, BinaryOp op) {
+    std::array<lane<T>, Accumulators> partial;
+    partial.fill(initial);
+
+    lanes<Accumulators>(in).for_each_step(
+        [&partial, &op] (auto k, lane<T> value) {
+            partial[k] = op(partial[k], value);
+        },
+        [&partial, &op] (lane<T> value) {
+            partial[0] = op(partial[0], value);
+        },
+        [&partial, &op] (T value) {
+            partial[0].a[0] = op(partial[0].a[0], value);
+        }
+    );
+
+    typename reduction_of<BinaryOp>::type merge;
+    for (auto stride = 1u; stride < Accumulators; stride *= 2) {
+        for (auto i = 0u; i + stride < Accumulators; i += 2*stride) {
+            partial[i] = merge(partial[i], partial[i + stride]);
+        }
     }
-    return op << result;
+    return op << partial[0];
 };
 
-template <typename T, int_t N>
-std::pair<T, int_t> max(gsl::span<T const, N> in) {
-    auto it = std::cbegin(in);
-    auto max = intrinsics::fill<T>()(std::numeric_limits<T>::lowest());
-    for (auto i = 0u; i < (in.size() % width<T>); ++i) {
-        max.a[i] = intrinsics::max<T>()(max.a[i], *(it++));
+// Lanes carry the offset of the chunk their current best element came from.
+// The offsets are kept as T, which stays exact up to 2^digits elements, so
+// they restart from every segment of that many elements, and the segments
+// are merged with their integer start.
+template <typename T>
+constexpr int_t exact_index_limit() {
+    return int_t{1} << std::min(std::numeric_limits<T>::digits, 62);
+}
+
+template <typename T, typename Compare, typename LaneFn, typename ScalarFn>
+element<T> arg_reduce(
+    int_t n,
+    Compare compare,
+    LaneFn lane_at,
+    ScalarFn scalar_at
+) {
+    assert(n > 0);
+
+    int_t i = 0;
+    element<T> best(scalar_at(0), std::size_t{0});
+
+    if (n >= 2*width<T>) {
+        auto const body = n / width<T> * width<T>;
+        constexpr auto segment = exact_index_limit<T>();
+        auto const step = set_lane(static_cast<T>(width<T>));
+
+        for (int_t start = 0; start < body; start += segment) {
+            auto const end = std::min(body, start + segment);
+            auto values = lane_at(start);
+            auto offsets = set_lane(static_cast<T>(0));
+            auto offset = offsets;
+
+            for (i = start + width<T>; i < end; i += width<T>) {
+                offset = add(offset, step);
+                auto const candidate = lane_at(i);
+                auto const mask = compare(candidate, values);
+                values = intrinsics::select<T>()(mask, candidate, values);
+                offsets = intrinsics::select<T>()(mask, offset, offsets);
+            }
+
+            for (auto j = 0; j < width<T>; ++j) {
+                auto const index = static_cast<std::size_t>(start)
+                    + static_cast<std::size_t>(offsets.a[j]) + j;
+                if (compare(values.a[j], best.value)
+                    || (!compare(best.value, values.a[j])
+                        && index < best.index)) {
+                    best = element<T>(values.a[j], index);
+                }
+            }
+        }
+        i = body;
+    } else {
+        i = 1;
     }
-    for (auto const end = std::cend(in); it < end; it += width<T>) {
-        auto temp = intrinsics::max<T>()(max, intrinsics::load<T>()(&(*it)));
-        if (intrinsics::any_greater_than<T>()(temp, max)) {
 
+    for (; i < n; ++i) {
+        auto const value = scalar_at(i);
+        if (compare(value, best.value)) {
+            best = element<T>(value, static_cast<std::size_t>(i));
         }
     }
-};
+    return best;
+}
 
+template <typename T, int_t N, typename Compare>
+element<T> arg_reduce(gsl::span<T const, N> in, Compare compare) {
+    auto const p = in.data();
+    return arg_reduce<T>(
+        std::size(in),
+        compare,
+        [p] (int_t i) { return load(p + i); },
+        [p] (int_t i) { return p[i]; }
+    );
+}
+
+// Returns the first largest element of a span along with its position.
 template <typename T, int_t N>
-T sum(gsl::span<T const, N> in) {
-    return reduce(in, intrinsics::zero<T>(), intrinsics::add<T>());
+element<T> max(gsl::span<T const, N> in) {
+    return arg_reduce(in, intrinsics::greater<T>());
 }
 
+// Returns the first smallest element of a span along with its position.
 template <typename T, int_t N>
+element<T> min(gsl::span<T const, N> in) {
+    return arg_reduce(in, intrinsics::less<T>());
+}
+
+// Evaluates op over two spans element-wise and returns the first largest
+// result, without materializing the intermediate values.
+template <typename T, int_t N1, int_t N2, typename BinaryOp>
+element<T> max_result(
+    gsl::span<T const, N1> in1,
+    gsl::span<T const, N2> in2,
+    BinaryOp op
+) {
+    assert(std::size(in1) == std::size(in2));
+    auto const p1 = in1.data();
+    auto const p2 = in2.data();
+    return arg_reduce<T>(
+        std::size(in1),
+        intrinsics::greater<T>(),
+        [p1, p2, &op] (int_t i) { return op(load(p1 + i), load(p2 + i)); },
+        [p1, p2, &op] (int_t i) { return op(p1[i], p2[i]); }
+    );
+}
+
+template <uint_t Accumulators = accumulators, typename T, int_t N>
+T sum(gsl::span<T const, N> in) {
+    return reduce<Accumulators>(in, intrinsics::zero<T>(), intrinsics::add<T>());
+}
+
+template <uint_t Accumulators = accumulators, typename T, int_t N>
 T mean(gsl::span<T const, N> in) {
-    return sum(in) / in.size();
+    return sum<Accumulators>(in) / in.size();
 }
 
-template <typename T, int_t N>
+template <uint_t Accumulators = accumulators, typename T, int_t N>
 T sum_of_squares(gsl::span<T const, N> in) {
-    return reduce(
+    return reduce<Accumulators>(
         in,
         intrinsics::zero<T>(),
         apply<T, intrinsics::add<T>, intrinsics::sqr<T>>()
     );
 };
 
+// Accumulates Sums running sums over any number of equally long spans in a
+// single pass, so every span is read from memory once. step(sums, x...)
+// adds its terms to the array of sums: for the body it gets lanes of the
+// spans and lane sums, for the unaligned ends scalars and scalar sums, so
+// it is best written with the intrinsics functors, which take either.
+template <
+    uint_t Sums,
+    uint_t Accumulators = accumulators,
+    typename StepFn,
+    typename... Ts,
+    int_t... Extents
+>
+auto fused_sums(StepFn step, gsl::span<Ts, Extents>... in) {
+    using T = std::remove_const_t<std::tuple_element_t<0, std::tuple<Ts...>>>;
+
+    std::array<std::array<lane<T>, Sums>, Accumulators> partial;
+    for (auto& sums : partial) {
+        sums.fill(intrinsics::zero<T>());
+    }
+    std::array<T, Sums> remainder;
+    remainder.fill(T{0});
+
+    lanes<Accumulators>(in...).for_each_step(
+        [&partial, &step] (auto k, auto... x) {
+            step(partial[k], x.get()...);
+        },
+        [&partial, &step] (auto... x) {
+            step(partial[0], x.get()...);
+        },
+        [&remainder, &step] (auto const&... x) {
+            step(remainder, static_cast<T>(x)...);
+        }
+    );
+
+    for (auto stride = 1u; stride < Accumulators; stride *= 2) {
+        for (auto i = 0u; i + stride < Accumulators; i += 2*stride) {
+            for (auto j = 0u; j < Sums; ++j) {
+                partial[i][j] = add(partial[i][j], partial[i + stride][j]);
+            }
+        }
+    }
+    for (auto j = 0u; j < Sums; ++j) {
+        remainder[j] += intrinsics::add<T>() << partial[0][j];
+    }
+    return remainder;
+}
+
+// Sum of a[i] * b[i].
+template <uint_t Accumulators = accumulators, typename T, int_t N1, int_t N2>
+T dot(gsl::span<T const, N1> a, gsl::span<T const, N2> b) {
+    return fused_sums<1, Accumulators>(
+        [] (auto& sums, auto x, auto y) {
+            sums[0] = intrinsics::mul_add<T>()(x, y, sums[0]);
+        },
+        a,
+        b
+    )[0];
+}
+
+// Sum of w[i] * x[i] over the sum of w[i].
+template <uint_t Accumulators = accumulators, typename T, int_t N1, int_t N2>
+T weighted_mean(gsl::span<T const, N1> x, gsl::span<T const, N2> w) {
+    auto const sums = fused_sums<2, Accumulators>(
+        [] (auto& sums, auto value, auto weight) {
+            sums[0] = intrinsics::mul_add<T>()(value, weight, sums[0]);
+            sums[1] = intrinsics::add<T>()(sums[1], weight);
+        },
+        x,
+        w
+    );
+    return sums[0] / sums[1];
+}
+
+// Sum of (a[i] - b[i])^2.
+template <uint_t Accumulators = accumulators, typename T, int_t N1, int_t N2>
+T squared_distance(gsl::span<T const, N1> a, gsl::span<T const, N2> b) {
+    return fused_sums<1, Accumulators>(
+        [] (auto& sums, auto x, auto y) {
+            auto const d = intrinsics::sub<T>()(x, y);
+            sums[0] = intrinsics::mul_add<T>()(d, d, sums[0]);
+        },
+        a,
+        b
+    )[0];
+}
+
+// Pearson correlation coefficient of a and b, from one pass over both. The
+// data is shifted by its first elements to keep the sums of squares from
+// cancelling out when the means are large.
+template <uint_t Accumulators = accumulators, typename T, int_t N1, int_t N2>
+T correlation(gsl::span<T const, N1> a, gsl::span<T const, N2> b) {
+    assert(std::size(a) == std::size(b) && std::size(a) > 0);
+    auto const a0 = a[0];
+    auto const b0 = b[0];
+    auto const shift_a = set_lane(a0);
+    auto const shift_b = set_lane(b0);
+
+    auto const sums = fused_sums<5, Accumulators>(
+        [&] (auto& sums, auto x, auto y) {
+            using U = decltype(x);
+            intrinsics::add<T> add;
+            intrinsics::mul_add<T> mul_add;
+            U dx, dy;
+            if constexpr (std::is_same<U, T>::value) {
+                dx = x - a0;
+                dy = y - b0;
+            } else {
+                dx = subtract(x, shift_a);
+                dy = subtract(y, shift_b);
+            }
+            sums[0] = add(sums[0], dx);
+            sums[1] = add(sums[1], dy);
+            sums[2] = mul_add(dx, dx, sums[2]);
+            sums[3] = mul_add(dy, dy, sums[3]);
+            sums[4] = mul_add(dx, dy, sums[4]);
+        },
+        a,
+        b
+    );
+
+    auto const n = static_cast<T>(std::size(a));
+    auto const var_a = sums[2] - sums[0] * sums[0] / n;
+    auto const var_b = sums[3] - sums[1] * sums[1] / n;
+    auto const cov = sums[4] - sums[0] * sums[1] / n;
+    return cov / std::sqrt(var_a * var_b);
+}
+
 }
 }
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <re/lib/common.hpp>
+#include <re/lib/simd/simd.hpp>
+
+namespace re {
+namespace simd {
+
+// Alignment of the widest vector register of the enabled backend.
+constexpr std::size_t alignment = std::max({
+    alignof(std::max_align_t),
+    sizeof(vec_t<float>),
+    sizeof(vec_t<double>)
+});
+
+template <typename T>
+inline bool is_aligned(T const* p, std::size_t a = alignment)
+noexcept {
+    return reinterpret_cast<std::uintptr_t>(p) % a == 0;
+}
+
+// Fixed-size buffer whose storage can be accessed with aligned loads/stores.
+template <typename T, std::size_t N>
+struct alignas(alignment) aligned_array : public std::array<T, N>
+{
+};
+
+template <typename T, std::size_t Alignment = alignment>
+class aligned_allocator
+{
+    static_assert((Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of 2.");
+
+    static constexpr std::align_val_t align_val{
+        std::max(Alignment, alignof(T))
+    };
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    constexpr aligned_allocator()
+    noexcept = default;
+
+    template <typename U>
+    constexpr aligned_allocator(aligned_allocator<U, Alignment> const&)
+    noexcept
+    {
+    }
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val));
+    }
+
+    void deallocate(T* p, std::size_t)
+    noexcept {
+        ::operator delete(p, align_val);
+    }
+
+    template <typename U>
+    constexpr bool operator==(aligned_allocator<U, Alignment> const&)
+    const noexcept {
+        return true;
+    }
+
+    template <typename U>
+    constexpr bool operator!=(aligned_allocator<U, Alignment> const&)
+    const noexcept {
+        return false;
+    }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include <re/lib/simd/identification.hpp>
+
+#if defined(RE_ARCH_X86)
+#include <xmmintrin.h>
+#endif
+
+namespace re {
+namespace simd {
+
+// Has the processor treat subnormal inputs and results as zero, in this
+// thread, for as long as it lives, and restores the mode it found. Where
+// there is no such mode it does nothing.
+//
+// Recursive filters decaying into silence would otherwise spend most of
+// their time on values of no consequence, which many processors take a
+// slow path for.
+class flush_to_zero {
+public:
+    flush_to_zero()
+    noexcept {
+#if defined(RE_ARCH_X86)
+        // Flush to zero and denormals are zero.
+        saved = _mm_getcsr();
+        _mm_setcsr(saved | 0x8040u);
+#elif defined(RE_ARCH_ARM64) && (defined(__GNUC__) || defined(__clang__))
+        std::uint64_t mode;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+        saved = mode;
+        mode |= std::uint64_t{1} << 24;
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#endif
+    }
+
+    ~flush_to_zero()
+    noexcept {
+#if defined(RE_ARCH_X86)
+        _mm_setcsr(static_cast<unsigned int>(saved));
+#elif defined(RE_ARCH_ARM64) && (defined(__GNUC__) || defined(__clang__))
+        std::uint64_t const mode = saved;
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(mode));
+#endif
+    }
+
+    flush_to_zero(flush_to_zero const&) = delete;
+    flush_to_zero& operator=(flush_to_zero const&) = delete;
+
+private:
+    [[maybe_unused]] std::uint64_t saved = 0;
+};
+
+}
+}
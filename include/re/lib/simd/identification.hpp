@@ -32,6 +32,12 @@
 #ifdef __AVX__
 #define RE_ARCH_AVX 1
 #endif
+#ifdef __AVX2__
+#define RE_ARCH_AVX2 1
+#endif
+#ifdef __FMA__
+#define RE_ARCH_FMA 1
+#endif
 #ifdef __AVX512F__
 #define RE_ARCH_AVX512 1
 #endif
@@ -54,6 +54,122 @@ load<double>::operator() (lane_ptr<double const> p)
     return _mm256_loadu_pd(p);
 }
 
+template <>
+inline lane<float>
+load_aligned<float>::operator() (lane_ptr<float const> p)
+{
+    return _mm256_load_ps(p);
+}
+
+template <>
+inline lane<double>
+load_aligned<double>::operator() (lane_ptr<double const> p)
+{
+    return _mm256_load_pd(p);
+}
+
+// Plain AVX has no 256 bit integer unpack, so int16 is sign extended one
+// 128 bit half at a time.
+template <>
+inline lane<float>
+convert<float>::operator() (lane_ptr<std::int16_t const> p)
+{
+    auto const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.ptr));
+    auto const low = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    auto const high = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    return _mm256_cvtepi32_ps(
+        _mm256_insertf128_si256(_mm256_castsi128_si256(low), high, 1)
+    );
+}
+
+template <>
+inline lane<float>
+convert<float>::operator() (lane_ptr<std::int32_t const> p)
+{
+    return _mm256_cvtepi32_ps(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.ptr))
+    );
+}
+
+template <>
+inline lane<double>
+convert<double>::operator() (lane_ptr<std::int16_t const> p)
+{
+    auto const x = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p.ptr));
+    return _mm256_cvtepi32_pd(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+
+template <>
+inline lane<double>
+convert<double>::operator() (lane_ptr<std::int32_t const> p)
+{
+    return _mm256_cvtepi32_pd(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.ptr))
+    );
+}
+
+#ifdef RE_ARCH_AVX2
+template <>
+inline lane<float>
+gather<float>::operator() (
+    float const* base,
+    lane_ptr<std::int32_t const> index
+) {
+    // The masked form, as the plain one leaves GCC warning about its
+    // unset source operand.
+    return _mm256_mask_i32gather_ps(
+        _mm256_setzero_ps(),
+        base,
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(index.ptr)),
+        _mm256_castsi256_ps(_mm256_set1_epi32(-1)),
+        sizeof(float)
+    );
+}
+
+template <>
+inline lane<double>
+gather<double>::operator() (
+    double const* base,
+    lane_ptr<std::int32_t const> index
+) {
+    return _mm256_mask_i32gather_pd(
+        _mm256_setzero_pd(),
+        base,
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(index.ptr)),
+        _mm256_castsi256_pd(_mm256_set1_epi64x(-1)),
+        sizeof(double)
+    );
+}
+#endif
+
+template <>
+inline void
+store<float>::operator() (lane_ptr<float> p, lane<float> value)
+{
+    _mm256_storeu_ps(p, value);
+}
+
+template <>
+inline void
+store<double>::operator() (lane_ptr<double> p, lane<double> value)
+{
+    _mm256_storeu_pd(p, value);
+}
+
+template <>
+inline void
+store_aligned<float>::operator() (lane_ptr<float> p, lane<float> value)
+{
+    _mm256_store_ps(p, value);
+}
+
+template <>
+inline void
+store_aligned<double>::operator() (lane_ptr<double> p, lane<double> value)
+{
+    _mm256_store_pd(p, value);
+}
+
 template <>
 lane<float>
 add<float>::operator() (lane<float> a, lane<float> b)
@@ -68,21 +184,28 @@ add<double>::operator() (lane<double> a, lane<double> b)
     return _mm256_add_pd(a, b);
 }
 
+// hadd works within 128-bit halves, so the halves are added first.
 template <>
 float add<float>::operator() (lane<float> a)
 {
-    a = _mm256_hadd_ps(a, a);
-    a = _mm256_hadd_ps(a, a);
-    a = _mm256_hadd_ps(a, a);
-    return a.a[0];
+    auto b = _mm_add_ps(
+        _mm256_castps256_ps128(a),
+        _mm256_extractf128_ps(a, 1)
+    );
+    b = _mm_hadd_ps(b, b);
+    b = _mm_hadd_ps(b, b);
+    return _mm_cvtss_f32(b);
 }
 
 template <>
 double add<double>::operator() (lane<double> a)
 {
-    a = _mm256_hadd_pd(a, a);
-    a = _mm256_hadd_pd(a, a);
-    return a.a[0];
+    auto b = _mm_add_pd(
+        _mm256_castpd256_pd128(a),
+        _mm256_extractf128_pd(a, 1)
+    );
+    b = _mm_hadd_pd(b, b);
+    return _mm_cvtsd_f64(b);
 }
 
 template <>
@@ -113,6 +236,36 @@ mul<double>::operator() (lane<double> a, lane<double> b)
     return _mm256_mul_pd(a, b);
 }
 
+#ifdef RE_ARCH_FMA
+template <>
+inline lane<float>
+mul_add<float>::operator() (lane<float> a, lane<float> b, lane<float> c)
+{
+    return _mm256_fmadd_ps(a, b, c);
+}
+
+template <>
+inline lane<double>
+mul_add<double>::operator() (lane<double> a, lane<double> b, lane<double> c)
+{
+    return _mm256_fmadd_pd(a, b, c);
+}
+#endif
+
+template <>
+inline lane<float>
+div<float>::operator() (lane<float> a, lane<float> b)
+{
+    return _mm256_div_ps(a, b);
+}
+
+template <>
+inline lane<double>
+div<double>::operator() (lane<double> a, lane<double> b)
+{
+    return _mm256_div_pd(a, b);
+}
+
 template <>
 lane<float>
 sqr<float>::operator() (lane<float> a)
@@ -169,6 +322,181 @@ max<double>::operator() (lane<double> a, lane<double> b)
     return _mm256_max_pd(a, b);
 }
 
+template <>
+inline lane<float>
+min<float>::operator() (lane<float> a, lane<float> b)
+{
+    return _mm256_min_ps(a, b);
+}
+
+template <>
+inline lane<double>
+min<double>::operator() (lane<double> a, lane<double> b)
+{
+    return _mm256_min_pd(a, b);
+}
+
+template <>
+inline lane<float>
+round<float>::operator() (lane<float> a)
+{
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+template <>
+inline lane<double>
+round<double>::operator() (lane<double> a)
+{
+    return _mm256_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+
+// The exponent is built in the integer domain: (n + bias) scaled to the
+// position of the exponent field converts to exactly the bits of 2^n.
+template <>
+inline lane<float>
+ldexp<float>::operator() (lane<float> a, lane<float> n)
+{
+    auto const bits = _mm256_cvtps_epi32(_mm256_mul_ps(
+        _mm256_add_ps(n, _mm256_set1_ps(127.f)),
+        _mm256_set1_ps(0x1p23f)
+    ));
+    return _mm256_mul_ps(a, _mm256_castsi256_ps(bits));
+}
+
+// Doubles get the biased exponent in the upper half of each element.
+template <>
+inline lane<double>
+ldexp<double>::operator() (lane<double> a, lane<double> n)
+{
+    auto const high = _mm256_cvtpd_epi32(_mm256_mul_pd(
+        _mm256_add_pd(n, _mm256_set1_pd(1023.)),
+        _mm256_set1_pd(0x1p20)
+    ));
+    auto const zero = _mm_setzero_si128();
+    auto const bits = _mm256_insertf128_si256(
+        _mm256_castsi128_si256(_mm_unpacklo_epi32(zero, high)),
+        _mm_unpackhi_epi32(zero, high),
+        1
+    );
+    return _mm256_mul_pd(a, _mm256_castsi256_pd(bits));
+}
+
+template <>
+inline lane<float>
+exponent<float>::operator() (lane<float> a)
+{
+    auto const field = _mm256_and_ps(
+        a,
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x7f800000))
+    );
+    return _mm256_sub_ps(
+        _mm256_mul_ps(
+            _mm256_cvtepi32_ps(_mm256_castps_si256(field)),
+            _mm256_set1_ps(0x1p-23f)
+        ),
+        _mm256_set1_ps(127.f)
+    );
+}
+
+template <>
+inline lane<double>
+exponent<double>::operator() (lane<double> a)
+{
+    auto const words = _mm256_castpd_ps(a);
+    auto const high = _mm_shuffle_ps(
+        _mm256_castps256_ps128(words),
+        _mm256_extractf128_ps(words, 1),
+        _MM_SHUFFLE(3, 1, 3, 1)
+    );
+    auto const field = _mm_and_si128(
+        _mm_castps_si128(high),
+        _mm_set1_epi32(0x7ff00000)
+    );
+    return _mm256_sub_pd(
+        _mm256_mul_pd(_mm256_cvtepi32_pd(field), _mm256_set1_pd(0x1p-20)),
+        _mm256_set1_pd(1023.)
+    );
+}
+
+template <>
+inline lane<float>
+mantissa<float>::operator() (lane<float> a)
+{
+    return _mm256_or_ps(
+        _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x007fffff))),
+        _mm256_set1_ps(1.f)
+    );
+}
+
+template <>
+inline lane<double>
+mantissa<double>::operator() (lane<double> a)
+{
+    return _mm256_or_pd(
+        _mm256_and_pd(
+            a,
+            _mm256_castsi256_pd(_mm256_set1_epi64x(0x000fffffffffffff))
+        ),
+        _mm256_set1_pd(1.)
+    );
+}
+
+template <>
+inline lane<float>
+greater<float>::operator() (lane<float> a, lane<float> b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+
+template <>
+inline lane<double>
+greater<double>::operator() (lane<double> a, lane<double> b)
+{
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+}
+
+template <>
+inline lane<float>
+less<float>::operator() (lane<float> a, lane<float> b)
+{
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+}
+
+template <>
+inline lane<double>
+less<double>::operator() (lane<double> a, lane<double> b)
+{
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+}
+
+template <>
+inline bool
+any_greater_than<float>::operator() (lane<float> a, lane<float> b)
+{
+    return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)) != 0;
+}
+
+template <>
+inline bool
+any_greater_than<double>::operator() (lane<double> a, lane<double> b)
+{
+    return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ)) != 0;
+}
+
+template <>
+inline lane<float>
+select<float>::operator() (lane<float> mask, lane<float> a, lane<float> b)
+{
+    return _mm256_blendv_ps(b, a, mask);
+}
+
+template <>
+inline lane<double>
+select<double>::operator() (lane<double> mask, lane<double> a, lane<double> b)
+{
+    return _mm256_blendv_pd(b, a, mask);
+}
+
 
 template <>
 lane <std::complex<float>>
@@ -197,19 +525,21 @@ mul<std::complex<float>>::operator()(
     lane <std::complex<float>> b
 )
 {
-    auto ac_bd = _mm256_mul_ps(a, b);
-    b = RE_SHUFFLE(8, b.v, b.v, 1, 0, 3, 2, 5, 4, 7, 6);
-    auto ad_bc = _mm256_mul_ps(a, b);
-    a.v = RE_SHUFFLE(8, ac_bd, ad_bc, 0, 8, 2, 10, 4, 12, 6, 14);
-    b.v = RE_SHUFFLE(8, ac_bd, ad_bc, 1, 9, 3, 11, 5, 13, 7, 15);
-
-    return _mm256_addsub_ps(a, b);
+    auto const b_re = _mm256_moveldup_ps(b);
+    auto const b_im = _mm256_movehdup_ps(b);
+    auto const a_swapped = _mm256_permute_ps(a, 0xb1);
+    auto const cross = _mm256_mul_ps(a_swapped, b_im);
+#ifdef RE_ARCH_FMA
+    return _mm256_fmaddsub_ps(a, b_re, cross);
+#else
+    return _mm256_addsub_ps(_mm256_mul_ps(a, b_re), cross);
+#endif
 }
 
 template <>
 inline lane<std::complex<float>>
 load<std::complex<float>>::operator()(lane_ptr<std::complex<float> const> p) {
-    return _mm256_load_ps(reinterpret_cast<float const*>(p.ptr));
+    return _mm256_loadu_ps(reinterpret_cast<float const*>(p.ptr));
 }
 
 template <>
@@ -217,6 +547,57 @@ inline void
 store<std::complex<float>>::operator()(
     lane_ptr<std::complex<float>> p,
     lane<std::complex<float>> value
+) {
+    _mm256_storeu_ps(reinterpret_cast<float*>(p.ptr), value);
+}
+
+// AVX has no shifts across a whole register, so each 128 bit half is
+// scanned by permutes and blends with zero, and the total of the lower half
+// is then carried into the upper one.
+template <>
+inline lane<float>
+prefix_sum<float>::operator()(lane<float> a) {
+    auto const zero = _mm256_setzero_ps();
+    __m256 x = a;
+    x = _mm256_add_ps(x, _mm256_blend_ps(
+        _mm256_permute_ps(x, _MM_SHUFFLE(2, 1, 0, 3)),
+        zero,
+        0x11
+    ));
+    x = _mm256_add_ps(x, _mm256_blend_ps(
+        _mm256_permute_ps(x, _MM_SHUFFLE(1, 0, 3, 2)),
+        zero,
+        0x33
+    ));
+    auto const total = _mm256_permute_ps(x, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_add_ps(x, _mm256_permute2f128_ps(total, total, 0x08));
+}
+template <>
+inline lane<double>
+prefix_sum<double>::operator()(lane<double> a) {
+    __m256d x = a;
+    x = _mm256_add_pd(x, _mm256_blend_pd(
+        _mm256_permute_pd(x, 0x0),
+        _mm256_setzero_pd(),
+        0x5
+    ));
+    auto const total = _mm256_permute_pd(x, 0xf);
+    return _mm256_add_pd(x, _mm256_permute2f128_pd(total, total, 0x08));
+}
+
+template <>
+inline lane<std::complex<float>>
+load_aligned<std::complex<float>>::operator()(
+    lane_ptr<std::complex<float> const> p
+) {
+    return _mm256_load_ps(reinterpret_cast<float const*>(p.ptr));
+}
+
+template <>
+inline void
+store_aligned<std::complex<float>>::operator()(
+    lane_ptr<std::complex<float>> p,
+    lane<std::complex<float>> value
 ) {
     _mm256_store_ps(reinterpret_cast<float*>(p.ptr), value);
 }
@@ -23,6 +23,102 @@ zero<double>() {
     return _mm512_setzero_pd();
 }
 
+template <>
+inline lane<float>
+load<float>::operator()(lane_ptr<float const> p) {
+    return _mm512_loadu_ps(p);
+}
+template <>
+inline lane<double>
+load<double>::operator()(lane_ptr<double const> p) {
+    return _mm512_loadu_pd(p);
+}
+
+template <>
+inline lane<float>
+load_aligned<float>::operator()(lane_ptr<float const> p) {
+    return _mm512_load_ps(p);
+}
+template <>
+inline lane<double>
+load_aligned<double>::operator()(lane_ptr<double const> p) {
+    return _mm512_load_pd(p);
+}
+
+template <>
+inline lane<float>
+convert<float>::operator()(lane_ptr<std::int16_t const> p) {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.ptr))
+    ));
+}
+template <>
+inline lane<float>
+convert<float>::operator()(lane_ptr<std::int32_t const> p) {
+    return _mm512_cvtepi32_ps(_mm512_loadu_si512(p.ptr));
+}
+template <>
+inline lane<double>
+convert<double>::operator()(lane_ptr<std::int16_t const> p) {
+    return _mm512_cvtepi32_pd(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.ptr))
+    ));
+}
+template <>
+inline lane<double>
+convert<double>::operator()(lane_ptr<std::int32_t const> p) {
+    return _mm512_cvtepi32_pd(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p.ptr))
+    );
+}
+
+template <>
+inline lane<float>
+gather<float>::operator()(
+    float const* base,
+    lane_ptr<std::int32_t const> index
+) {
+    return _mm512_i32gather_ps(
+        _mm512_loadu_si512(index.ptr),
+        base,
+        sizeof(float)
+    );
+}
+template <>
+inline lane<double>
+gather<double>::operator()(
+    double const* base,
+    lane_ptr<std::int32_t const> index
+) {
+    return _mm512_i32gather_pd(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const*>(index.ptr)),
+        base,
+        sizeof(double)
+    );
+}
+
+template <>
+inline void
+store<float>::operator()(lane_ptr<float> p, lane<float> value) {
+    _mm512_storeu_ps(p, value);
+}
+template <>
+inline void
+store<double>::operator()(lane_ptr<double> p, lane<double> value) {
+    _mm512_storeu_pd(p, value);
+}
+
+template <>
+inline void
+store_aligned<float>::operator()(lane_ptr<float> p, lane<float> value) {
+    _mm512_store_ps(p, value);
+}
+template <>
+inline void
+store_aligned<double>::operator()(lane_ptr<double> p, lane<double> value) {
+    _mm512_store_pd(p, value);
+}
+
 template <>
 lane<float>
 add<float>::operator()(lane<float> a, lane<float> b) {
@@ -56,6 +152,28 @@ mul<double>::operator()(lane<double> a, lane<double> b) {
     return _mm512_mul_pd(a, b);
 }
 
+template <>
+inline lane<float>
+mul_add<float>::operator()(lane<float> a, lane<float> b, lane<float> c) {
+    return _mm512_fmadd_ps(a, b, c);
+}
+template <>
+inline lane<double>
+mul_add<double>::operator()(lane<double> a, lane<double> b, lane<double> c) {
+    return _mm512_fmadd_pd(a, b, c);
+}
+
+template <>
+inline lane<float>
+div<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm512_div_ps(a, b);
+}
+template <>
+inline lane<double>
+div<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm512_div_pd(a, b);
+}
+
 template <>
 lane<float>
 sqr<float>::operator()(lane<float> a) {
@@ -92,11 +210,161 @@ hadd<float>::operator()(lane<float> a, lane<float> b) {
 template <>
 lane<double>
 hadd<double>::operator()(lane<double> a, lane<double> b) {
-    auto even = RE_SHUFFLE(8, a.v, b.v, 0, 2, 4, 6, 8, 10, 12, 14);
-    auto odd = RE_SHUFFLE(8, a.v, b.v, 1, 3, 5, 7, 9, 11, 13, 15);
+    auto even = _mm512_permutex2var_pd(
+        a, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), b
+    );
+    auto odd = _mm512_permutex2var_pd(
+        a, _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15), b
+    );
     return _mm512_add_pd(even, odd);
 }
 
+template <>
+inline lane<float>
+max<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm512_max_ps(a, b);
+}
+template <>
+inline lane<double>
+max<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm512_max_pd(a, b);
+}
+
+template <>
+inline lane<float>
+min<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm512_min_ps(a, b);
+}
+template <>
+inline lane<double>
+min<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm512_min_pd(a, b);
+}
+
+template <>
+inline lane<float>
+round<float>::operator()(lane<float> a) {
+    return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEAREST_INT);
+}
+template <>
+inline lane<double>
+round<double>::operator()(lane<double> a) {
+    return _mm512_roundscale_pd(a, _MM_FROUND_TO_NEAREST_INT);
+}
+
+template <>
+inline lane<float>
+ldexp<float>::operator()(lane<float> a, lane<float> n) {
+    return _mm512_scalef_ps(a, n);
+}
+template <>
+inline lane<double>
+ldexp<double>::operator()(lane<double> a, lane<double> n) {
+    return _mm512_scalef_pd(a, n);
+}
+
+template <>
+inline lane<float>
+exponent<float>::operator()(lane<float> a) {
+    return _mm512_getexp_ps(a);
+}
+template <>
+inline lane<double>
+exponent<double>::operator()(lane<double> a) {
+    return _mm512_getexp_pd(a);
+}
+
+template <>
+inline lane<float>
+mantissa<float>::operator()(lane<float> a) {
+    return _mm512_getmant_ps(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+}
+template <>
+inline lane<double>
+mantissa<double>::operator()(lane<double> a) {
+    return _mm512_getmant_pd(a, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src);
+}
+
+// AVX-512 compares produce k-masks; they are widened back into lanes so that
+// the mask convention matches the other backends.
+template <>
+inline lane<float>
+greater<float>::operator()(lane<float> a, lane<float> b) {
+    auto const k = _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+    return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(k, -1));
+}
+template <>
+inline lane<double>
+greater<double>::operator()(lane<double> a, lane<double> b) {
+    auto const k = _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+    return _mm512_castsi512_pd(_mm512_maskz_set1_epi64(k, -1));
+}
+
+template <>
+inline lane<float>
+less<float>::operator()(lane<float> a, lane<float> b) {
+    auto const k = _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+    return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(k, -1));
+}
+template <>
+inline lane<double>
+less<double>::operator()(lane<double> a, lane<double> b) {
+    auto const k = _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+    return _mm512_castsi512_pd(_mm512_maskz_set1_epi64(k, -1));
+}
+template <>
+inline bool
+any_greater_than<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ) != 0;
+}
+template <>
+inline bool
+any_greater_than<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ) != 0;
+}
+
+// Adds the lane to itself shifted up by 1, 2, 4 and 8 elements, zeroing
+// the elements shifted in.
+template <>
+inline lane<float>
+prefix_sum<float>::operator()(lane<float> a) {
+    auto const index = _mm512_set_epi32(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0
+    );
+    __m512 x = a;
+    for (auto shift : {1, 2, 4, 8}) {
+        auto const from = _mm512_sub_epi32(index, _mm512_set1_epi32(shift));
+        auto const mask = static_cast<__mmask16>(0xffff << shift);
+        x = _mm512_add_ps(x, _mm512_maskz_permutexvar_ps(mask, from, x));
+    }
+    return x;
+}
+template <>
+inline lane<double>
+prefix_sum<double>::operator()(lane<double> a) {
+    auto const index = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+    __m512d x = a;
+    for (auto shift : {1, 2, 4}) {
+        auto const from = _mm512_sub_epi64(index, _mm512_set1_epi64(shift));
+        auto const mask = static_cast<__mmask8>(0xff << shift);
+        x = _mm512_add_pd(x, _mm512_maskz_permutexvar_pd(mask, from, x));
+    }
+    return x;
+}
+
+template <>
+inline lane<float>
+select<float>::operator()(lane<float> mask, lane<float> a, lane<float> b) {
+    auto const bits = _mm512_castps_si512(mask);
+    return _mm512_mask_blend_ps(_mm512_test_epi32_mask(bits, bits), b, a);
+}
+template <>
+inline lane<double>
+select<double>::operator()(lane<double> mask, lane<double> a, lane<double> b) {
+    auto const bits = _mm512_castpd_si512(mask);
+    return _mm512_mask_blend_pd(_mm512_test_epi64_mask(bits, bits), b, a);
+}
+
 }
 }
 }
@@ -17,9 +17,27 @@ zero<float>() {
 }
 
 template <>
-lane<float>
-load<float>::operator() (float const* data) {
-    return vld1q_f32(data);
+inline lane<float>
+load<float>::operator() (lane_ptr<float const> p) {
+    return vld1q_f32(p.ptr);
+}
+
+template <>
+inline lane<float>
+convert<float>::operator() (lane_ptr<std::int16_t const> p) {
+    return vcvtq_f32_s32(vmovl_s16(vld1_s16(p.ptr)));
+}
+
+template <>
+inline lane<float>
+convert<float>::operator() (lane_ptr<std::int32_t const> p) {
+    return vcvtq_f32_s32(vld1q_s32(p.ptr));
+}
+
+template <>
+inline void
+store<float>::operator() (lane_ptr<float> p, lane<float> value) {
+    vst1q_f32(p.ptr, value);
 }
 
 template <>
@@ -28,7 +46,7 @@ add<float>::operator() (lane<float> a, lane<float> b) {
     return vaddq_f32(a, b);
 }
 template <>
-lane<float>
+float
 add<float>::operator<< (lane<float> a) {
     auto p = vpadd_f32(vget_low_f32(a), vget_high_f32(a));
     return vget_lane_f32(p, 0) + vget_lane_f32(p, 1);
@@ -46,6 +64,30 @@ mul<float>::operator() (lane<float> a, lane<float> b) {
     return vmulq_f32(a, b);
 }
 
+template <>
+inline lane<float>
+mul_add<float>::operator() (lane<float> a, lane<float> b, lane<float> c) {
+#ifdef RE_ARCH_ARM64
+    return vfmaq_f32(c, a, b);
+#else
+    return vmlaq_f32(c, a, b);
+#endif
+}
+
+// ARMv7 has no vector divide; the reciprocal estimate is refined twice.
+template <>
+inline lane<float>
+div<float>::operator() (lane<float> a, lane<float> b) {
+#ifdef RE_ARCH_ARM64
+    return vdivq_f32(a, b);
+#else
+    auto r = vrecpeq_f32(b);
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    return vmulq_f32(a, r);
+#endif
+}
+
 template <>
 lane<float>
 sqr<float>::operator() (lane<float> a) {
@@ -58,6 +100,93 @@ sqrt<float>::operator() (lane<float> a) {
     return vmulq_f32(a, vrsqrteq_f32(a));
 }
 
+template <>
+inline lane<float>
+max<float>::operator() (lane<float> a, lane<float> b) {
+    return vmaxq_f32(a, b);
+}
+
+template <>
+inline lane<float>
+min<float>::operator() (lane<float> a, lane<float> b) {
+    return vminq_f32(a, b);
+}
+
+template <>
+inline lane<float>
+round<float>::operator() (lane<float> a) {
+#ifdef RE_ARCH_ARM64
+    return vrndnq_f32(a);
+#else
+    auto const magic = vdupq_n_u32(0x4b000000);
+    auto const sign = vdupq_n_u32(0x80000000);
+    auto const bits = vreinterpretq_u32_f32(a);
+    auto const shifted = vreinterpretq_f32_u32(
+        vorrq_u32(magic, vandq_u32(sign, bits))
+    );
+    auto const rounded = vsubq_f32(vaddq_f32(a, shifted), shifted);
+    auto const small = vcltq_f32(vabsq_f32(a), vreinterpretq_f32_u32(magic));
+    return vbslq_f32(small, rounded, a);
+#endif
+}
+
+template <>
+inline lane<float>
+ldexp<float>::operator() (lane<float> a, lane<float> n) {
+    auto const biased = vcvtq_s32_f32(vaddq_f32(n, vdupq_n_f32(127.f)));
+    return vmulq_f32(a, vreinterpretq_f32_s32(vshlq_n_s32(biased, 23)));
+}
+
+template <>
+inline lane<float>
+exponent<float>::operator() (lane<float> a) {
+    auto const field = vandq_u32(
+        vshrq_n_u32(vreinterpretq_u32_f32(a), 23),
+        vdupq_n_u32(0xff)
+    );
+    return vsubq_f32(
+        vcvtq_f32_s32(vreinterpretq_s32_u32(field)),
+        vdupq_n_f32(127.f)
+    );
+}
+
+template <>
+inline lane<float>
+mantissa<float>::operator() (lane<float> a) {
+    auto const bits = vandq_u32(
+        vreinterpretq_u32_f32(a),
+        vdupq_n_u32(0x007fffff)
+    );
+    return vreinterpretq_f32_u32(vorrq_u32(bits, vdupq_n_u32(0x3f800000)));
+}
+
+template <>
+inline lane<float>
+greater<float>::operator() (lane<float> a, lane<float> b) {
+    return vreinterpretq_f32_u32(vcgtq_f32(a, b));
+}
+
+template <>
+inline lane<float>
+less<float>::operator() (lane<float> a, lane<float> b) {
+    return vreinterpretq_f32_u32(vcltq_f32(a, b));
+}
+
+template <>
+inline lane<float>
+select<float>::operator() (lane<float> mask, lane<float> a, lane<float> b) {
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+
+template <>
+inline lane<float>
+prefix_sum<float>::operator() (lane<float> a) {
+    auto const zero = vdupq_n_f32(0);
+    float32x4_t x = a;
+    x = vaddq_f32(x, vextq_f32(zero, x, 3));
+    return vaddq_f32(x, vextq_f32(zero, x, 2));
+}
+
 template <>
 lane<float>
 hadd<float>::operator() (lane<float> a, lane<float> b)
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <pmmintrin.h>
+#ifdef RE_ARCH_SSE4_1
+#include <smmintrin.h>
+#endif
 #include <re/lib/simd/intrinsics/template.hpp>
 
 namespace re {
@@ -12,15 +15,90 @@ template <> struct vector_of<double> { using type = __m128d; };
 namespace intrinsics {
 
 template <> lane<float>
-zero<float>::operator()() {
+zero<float>() {
     return _mm_setzero_ps();
 }
 
 template <> lane<double>
-zero<double>::operator()() {
+zero<double>() {
     return _mm_setzero_pd();
 }
 
+template <>
+inline lane<float>
+load<float>::operator()(lane_ptr<float const> p) {
+    return _mm_loadu_ps(p);
+}
+template <>
+inline lane<double>
+load<double>::operator()(lane_ptr<double const> p) {
+    return _mm_loadu_pd(p);
+}
+
+template <>
+inline lane<float>
+load_aligned<float>::operator()(lane_ptr<float const> p) {
+    return _mm_load_ps(p);
+}
+template <>
+inline lane<double>
+load_aligned<double>::operator()(lane_ptr<double const> p) {
+    return _mm_load_pd(p);
+}
+
+// Without SSE4.1 int16 is sign extended by unpacking each sample into the
+// upper half of a 32 bit word and shifting it back down.
+template <>
+inline lane<float>
+convert<float>::operator()(lane_ptr<std::int16_t const> p) {
+    auto const x = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p.ptr));
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+template <>
+inline lane<float>
+convert<float>::operator()(lane_ptr<std::int32_t const> p) {
+    return _mm_cvtepi32_ps(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(p.ptr))
+    );
+}
+template <>
+inline lane<double>
+convert<double>::operator()(lane_ptr<std::int16_t const> p) {
+    std::int32_t pair;
+    std::memcpy(&pair, p.ptr, sizeof(pair));
+    auto const x = _mm_cvtsi32_si128(pair);
+    return _mm_cvtepi32_pd(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+}
+template <>
+inline lane<double>
+convert<double>::operator()(lane_ptr<std::int32_t const> p) {
+    return _mm_cvtepi32_pd(
+        _mm_loadl_epi64(reinterpret_cast<__m128i const*>(p.ptr))
+    );
+}
+
+template <>
+inline void
+store<float>::operator()(lane_ptr<float> p, lane<float> value) {
+    _mm_storeu_ps(p, value);
+}
+template <>
+inline void
+store<double>::operator()(lane_ptr<double> p, lane<double> value) {
+    _mm_storeu_pd(p, value);
+}
+
+template <>
+inline void
+store_aligned<float>::operator()(lane_ptr<float> p, lane<float> value) {
+    _mm_store_ps(p, value);
+}
+template <>
+inline void
+store_aligned<double>::operator()(lane_ptr<double> p, lane<double> value) {
+    _mm_store_pd(p, value);
+}
+
 template <> lane<float>
 add<float>::operator()(lane<float> a, lane<float> b) {
     return _mm_add_ps(a, b);
@@ -32,11 +110,13 @@ add<double>::operator()(lane<double> a, lane<double> b) {
 template <> float
 add<float>::operator<<(lane<float> a) {
     a = _mm_hadd_ps(a, a);
-    return _mm_hadd_ps(a, a);
+    a = _mm_hadd_ps(a, a);
+    return a.a[0];
 }
 template <> double
 add<double>::operator<<(lane<double> a) {
-    return _mm_hadd_pd(a, a);
+    a = _mm_hadd_pd(a, a);
+    return a.a[0];
 }
 
 template <> lane<float>
@@ -60,6 +140,17 @@ mul<double>::operator()(lane<double> a, lane<double> b) {
     return _mm_mul_pd(a, b);
 }
 
+template <>
+inline lane<float>
+div<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm_div_ps(a, b);
+}
+template <>
+inline lane<double>
+div<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_div_pd(a, b);
+}
+
 template <>
 lane<float>
 sqr<float>::operator()(lane<float> a) {
@@ -93,12 +184,202 @@ hadd<double>::operator()(lane<double> a, lane<double> b) {
     return _mm_hadd_pd(a, b);
 }
 
+template <>
+inline lane<float>
+max<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm_max_ps(a, b);
+}
+template <>
+inline lane<double>
+max<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_max_pd(a, b);
+}
+
+template <>
+inline lane<float>
+min<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm_min_ps(a, b);
+}
+template <>
+inline lane<double>
+min<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_min_pd(a, b);
+}
+
+#ifdef RE_ARCH_SSE4_1
+template <>
+inline lane<float>
+round<float>::operator()(lane<float> a) {
+    return _mm_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+template <>
+inline lane<double>
+round<double>::operator()(lane<double> a) {
+    return _mm_round_pd(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+}
+#else
+// Adding and removing 2^(digits - 1) rounds away the fraction. Elements
+// beyond that magnitude are integers already and pass through.
+template <>
+inline lane<float>
+round<float>::operator()(lane<float> a) {
+    auto const magic = _mm_set1_ps(0x1p23f);
+    auto const sign = _mm_set1_ps(-0.f);
+    auto const magnitude = _mm_andnot_ps(sign, a);
+    auto const shifted = _mm_or_ps(magic, _mm_and_ps(sign, a));
+    auto const rounded = _mm_sub_ps(_mm_add_ps(a, shifted), shifted);
+    auto const small = _mm_cmplt_ps(magnitude, magic);
+    return _mm_or_ps(_mm_and_ps(small, rounded), _mm_andnot_ps(small, a));
+}
+template <>
+inline lane<double>
+round<double>::operator()(lane<double> a) {
+    auto const magic = _mm_set1_pd(0x1p52);
+    auto const sign = _mm_set1_pd(-0.);
+    auto const magnitude = _mm_andnot_pd(sign, a);
+    auto const shifted = _mm_or_pd(magic, _mm_and_pd(sign, a));
+    auto const rounded = _mm_sub_pd(_mm_add_pd(a, shifted), shifted);
+    auto const small = _mm_cmplt_pd(magnitude, magic);
+    return _mm_or_pd(_mm_and_pd(small, rounded), _mm_andnot_pd(small, a));
+}
+#endif
+
+// The exponent is built in the integer domain: (n + bias) scaled to the
+// position of the exponent field converts to exactly the bits of 2^n.
+template <>
+inline lane<float>
+ldexp<float>::operator()(lane<float> a, lane<float> n) {
+    auto const bits = _mm_cvtps_epi32(_mm_mul_ps(
+        _mm_add_ps(n, _mm_set1_ps(127.f)),
+        _mm_set1_ps(0x1p23f)
+    ));
+    return _mm_mul_ps(a, _mm_castsi128_ps(bits));
+}
+// Doubles get the biased exponent in the upper half of each element.
+template <>
+inline lane<double>
+ldexp<double>::operator()(lane<double> a, lane<double> n) {
+    auto const high = _mm_cvtpd_epi32(_mm_mul_pd(
+        _mm_add_pd(n, _mm_set1_pd(1023.)),
+        _mm_set1_pd(0x1p20)
+    ));
+    auto const bits = _mm_unpacklo_epi32(_mm_setzero_si128(), high);
+    return _mm_mul_pd(a, _mm_castsi128_pd(bits));
+}
+
+template <>
+inline lane<float>
+exponent<float>::operator()(lane<float> a) {
+    auto const field = _mm_and_ps(
+        a,
+        _mm_castsi128_ps(_mm_set1_epi32(0x7f800000))
+    );
+    return _mm_sub_ps(
+        _mm_mul_ps(
+            _mm_cvtepi32_ps(_mm_castps_si128(field)),
+            _mm_set1_ps(0x1p-23f)
+        ),
+        _mm_set1_ps(127.f)
+    );
+}
+template <>
+inline lane<double>
+exponent<double>::operator()(lane<double> a) {
+    auto const words = _mm_castpd_ps(a);
+    auto const high = _mm_shuffle_ps(words, words, _MM_SHUFFLE(3, 1, 3, 1));
+    auto const field = _mm_and_si128(
+        _mm_castps_si128(high),
+        _mm_set1_epi32(0x7ff00000)
+    );
+    return _mm_sub_pd(
+        _mm_mul_pd(_mm_cvtepi32_pd(field), _mm_set1_pd(0x1p-20)),
+        _mm_set1_pd(1023.)
+    );
+}
+
+template <>
+inline lane<float>
+mantissa<float>::operator()(lane<float> a) {
+    return _mm_or_ps(
+        _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x007fffff))),
+        _mm_set1_ps(1.f)
+    );
+}
+template <>
+inline lane<double>
+mantissa<double>::operator()(lane<double> a) {
+    return _mm_or_pd(
+        _mm_and_pd(a, _mm_castsi128_pd(_mm_set1_epi64x(0x000fffffffffffff))),
+        _mm_set1_pd(1.)
+    );
+}
+
+template <>
+inline lane<float>
+greater<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm_cmpgt_ps(a, b);
+}
+template <>
+inline lane<double>
+greater<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_cmpgt_pd(a, b);
+}
+
+template <>
+inline lane<float>
+less<float>::operator()(lane<float> a, lane<float> b) {
+    return _mm_cmplt_ps(a, b);
+}
+template <>
+inline lane<double>
+less<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_cmplt_pd(a, b);
+}
+
+template <>
+inline lane<float>
+select<float>::operator()(lane<float> mask, lane<float> a, lane<float> b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+template <>
+inline lane<double>
+select<double>::operator()(lane<double> mask, lane<double> a, lane<double> b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+// Adds the lane to itself shifted up by one and then two elements.
+template <>
+inline lane<float>
+prefix_sum<float>::operator()(lane<float> a) {
+    auto x = _mm_castps_si128(a);
+    x = _mm_castps_si128(_mm_add_ps(
+        _mm_castsi128_ps(x),
+        _mm_castsi128_ps(_mm_slli_si128(x, 4))
+    ));
+    return _mm_add_ps(
+        _mm_castsi128_ps(x),
+        _mm_castsi128_ps(_mm_slli_si128(x, 8))
+    );
+}
+template <>
+inline lane<double>
+prefix_sum<double>::operator()(lane<double> a) {
+    auto const x = _mm_castpd_si128(a);
+    return _mm_add_pd(a, _mm_castsi128_pd(_mm_slli_si128(x, 8)));
+}
+
 template <>
 bool
 any_greater_than<float>::operator()(lane<float> a, lane<float> b) {
     return _mm_movemask_ps(_mm_cmpgt_ps(a, b)) > 0;
 }
 
+template <>
+inline bool
+any_greater_than<double>::operator()(lane<double> a, lane<double> b) {
+    return _mm_movemask_pd(_mm_cmpgt_pd(a, b)) > 0;
+}
+
 }
 
 }
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+
 #include <algorithm>
 #include <array>
 #include <bitset>
 #include <cmath>
+#include <cstring>
 #include <numeric>
 #include <functional>
 
@@ -60,6 +64,30 @@ lane<T>& lane_transform(lane<T> const& a, lane<T>& output, UnaryOp op) {
     return output;
 };
 
+// Comparisons yield lanes with all bits of a matching element set, the same
+// convention the x86 compare instructions follow.
+template <typename T>
+T lane_mask(bool value) {
+    std::array<unsigned char, sizeof(T)> bits;
+    bits.fill(value ? 0xff : 0x00);
+    T mask;
+    std::memcpy(&mask, bits.data(), sizeof(T));
+    return mask;
+}
+
+template <typename T>
+bool lane_mask_test(T mask) {
+    std::array<unsigned char, sizeof(T)> bits;
+    std::memcpy(bits.data(), &mask, sizeof(T));
+    return std::any_of(
+        std::cbegin(bits),
+        std::cend(bits),
+        [](unsigned char b) {
+            return b != 0;
+        }
+    );
+}
+
 template <typename T, typename BinaryOp>
 T lane_accumulate(lane<T> const& a, T initial, BinaryOp op) {
     return std::accumulate(
@@ -108,6 +136,49 @@ template <typename T> struct store {
         std::copy(std::begin(value.a), std::end(value.a), p.ptr);
     }
 };
+// Integer samples converted to T, one element or a lane worth at a time.
+template <typename T> struct convert {
+    T operator()(std::int16_t const* p) {
+        return static_cast<T>(*p);
+    }
+    T operator()(std::int32_t const* p) {
+        return static_cast<T>(*p);
+    }
+    lane<T> operator()(lane_ptr<std::int16_t const> p) {
+        lane<T> v;
+        std::copy(p.ptr, p.ptr + width<T>, begin(v.a));
+        return v;
+    }
+    lane<T> operator()(lane_ptr<std::int32_t const> p) {
+        lane<T> v;
+        std::copy(p.ptr, p.ptr + width<T>, begin(v.a));
+        return v;
+    }
+};
+// Elements of base at the given indices, one or a lane worth at a time.
+template <typename T> struct gather {
+    T operator()(T const* base, std::int32_t const* index) {
+        return base[*index];
+    }
+    lane<T> operator()(T const* base, lane_ptr<std::int32_t const> index) {
+        lane<T> v;
+        for (auto i = 0; i < width<T>; ++i) {
+            v.a[i] = base[index.ptr[i]];
+        }
+        return v;
+    }
+};
+// The aligned variants may assume the pointer meets alignof(vec_t<T>).
+template <typename T> struct load_aligned {
+    lane<T> operator()(lane_ptr<T const> p) {
+        return load<T>()(p);
+    }
+};
+template <typename T> struct store_aligned {
+    void operator()(lane_ptr<T> p, lane<T> value) {
+        store<T>()(p, value);
+    }
+};
 template <typename T> struct fill {
     lane<T> operator()(T value) {
         lane<T> v;
@@ -153,6 +224,22 @@ template <typename T> struct mul {
         return lane_transform(a, b, a, mul<T>());
     }
 };
+// a * b + c, fused where the backend supports it.
+template <typename T> struct mul_add {
+    constexpr T operator()(T a, T b, T c) { return a * b + c; }
+    lane<T> operator()(lane<T> a, lane<T> b, lane<T> c) {
+        for (auto i = 0; i < width<T>; ++i) {
+            a.a[i] = a.a[i] * b.a[i] + c.a[i];
+        }
+        return a;
+    }
+};
+template <typename T> struct div {
+    constexpr T operator()(T a, T b) { return a / b; }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return lane_transform(a, b, a, div<T>());
+    }
+};
 template <typename T> struct sqr {
     constexpr T operator()(T a) { return a * a; }
     lane<T> operator()(lane<T> a) {
@@ -165,12 +252,47 @@ template <typename T> struct sqrt {
         return lane_transform(a, a, sqrt<T>());
     }
 };
+// Nearest integer, ties to even.
+template <typename T> struct round {
+    T operator()(T a) { return std::nearbyint(a); }
+    lane<T> operator()(lane<T> a) {
+        return lane_transform(a, a, round<T>());
+    }
+};
+// a * 2^n for integer valued n that is a normal exponent of T.
+template <typename T> struct ldexp {
+    T operator()(T a, T n) { return std::ldexp(a, static_cast<int>(n)); }
+    lane<T> operator()(lane<T> a, lane<T> n) {
+        return lane_transform(a, n, a, ldexp<T>());
+    }
+};
+// floor(log2(a)) and a / 2^floor(log2(a)), in [1, 2), of positive normal a.
+template <typename T> struct exponent {
+    T operator()(T a) { return static_cast<T>(std::ilogb(a)); }
+    lane<T> operator()(lane<T> a) {
+        return lane_transform(a, a, exponent<T>());
+    }
+};
+template <typename T> struct mantissa {
+    T operator()(T a) { return std::scalbn(a, -std::ilogb(a)); }
+    lane<T> operator()(lane<T> a) {
+        return lane_transform(a, a, mantissa<T>());
+    }
+};
 template <typename T> struct reduce_add {
     T operator()(lane<T> a) {
         return lane_accumulate(a, static_cast<T>(0), std::plus<T>());
     }
 };
 
+// Running sums across the lane, element i holding the sum of elements 0..i.
+template <typename T> struct prefix_sum {
+    lane<T> operator()(lane<T> a) {
+        std::partial_sum(std::cbegin(a.a), std::cend(a.a), std::begin(a.a));
+        return a;
+    }
+};
+
 template <typename T> struct max {
     T operator()(T a, T b) {
         return std::fmax(a, b);
@@ -178,6 +300,58 @@ template <typename T> struct max {
     lane<T> operator()(lane<T> a, lane<T> b) {
         return lane_transform(a, b, a, *this);
     }
+    T operator<<(lane<T> a) {
+        return lane_accumulate(a, a.a[0], *this);
+    }
+};
+
+template <typename T> struct min {
+    T operator()(T a, T b) {
+        return std::fmin(a, b);
+    }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return lane_transform(a, b, a, *this);
+    }
+    T operator<<(lane<T> a) {
+        return lane_accumulate(a, a.a[0], *this);
+    }
+};
+
+template <typename T> struct greater {
+    bool operator()(T a, T b) {
+        return a > b;
+    }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return lane_transform(a, b, a, [](T x, T y) {
+            return lane_mask<T>(x > y);
+        });
+    }
+};
+
+template <typename T> struct less {
+    bool operator()(T a, T b) {
+        return a < b;
+    }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return lane_transform(a, b, a, [](T x, T y) {
+            return lane_mask<T>(x < y);
+        });
+    }
+};
+
+// Picks elements of `a` where `mask` is set and elements of `b` elsewhere.
+template <typename T> struct select {
+    T operator()(bool mask, T a, T b) {
+        return mask ? a : b;
+    }
+    lane<T> operator()(lane<T> mask, lane<T> a, lane<T> b) {
+        for (auto i = 0; i < width<T>; ++i) {
+            if (!lane_mask_test(mask.a[i])) {
+                a.a[i] = b.a[i];
+            }
+        }
+        return a;
+    }
 };
 
 template <typename T> struct any_greater_than {
@@ -185,13 +359,12 @@ template <typename T> struct any_greater_than {
         return a > b;
     }
     bool operator()(lane<T> a, lane<T> b) {
-        return lane_accumulate(
-            sub<T>()(a, b),
-            false,
-            [](bool r, T d) {
-                return r || d > 0;
+        for (auto i = 0; i < width<T>; ++i) {
+            if (a.a[i] > b.a[i]) {
+                return true;
             }
-        );
+        }
+        return false;
     }
 };
 
@@ -208,6 +381,30 @@ inline void store(T* p, lane<T> value) {
     intrinsics::store<T>()(lane_ptr<T>(p), value);
 }
 
+// Loads width<T> integers and converts them to T.
+template <typename T, typename I>
+inline lane<T> load_converted(I const* p) {
+    return intrinsics::convert<T>()(lane_ptr<I const>(p));
+}
+
+// Loads base[index[0]], ..., base[index[width<T> - 1]].
+template <typename T>
+inline lane<T> load_gathered(T const* base, std::int32_t const* index) {
+    return intrinsics::gather<T>()(base, lane_ptr<std::int32_t const>(index));
+}
+
+template <typename T>
+inline lane<T> load_aligned(T const* p) {
+    assert(reinterpret_cast<std::uintptr_t>(p) % alignof(vec_t<T>) == 0);
+    return intrinsics::load_aligned<T>()(lane_ptr<T const>(p));
+}
+
+template <typename T>
+inline void store_aligned(T* p, lane<T> value) {
+    assert(reinterpret_cast<std::uintptr_t>(p) % alignof(vec_t<T>) == 0);
+    intrinsics::store_aligned<T>()(lane_ptr<T>(p), value);
+}
+
 
 template <typename T>
 inline lane<T> add(lane<T> a, lane<T> b) {
@@ -224,6 +421,11 @@ inline lane<T> multiply(lane<T> a, lane<T> b) {
     return intrinsics::mul<T>()(a, b);
 }
 
+template <typename T>
+inline lane<T> divide(lane<T> a, lane<T> b) {
+    return intrinsics::div<T>()(a, b);
+}
+
 template <typename T>
 inline lane<T> set_lane(T value) {
     return intrinsics::set<T>()(value);
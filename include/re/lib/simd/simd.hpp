@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -23,6 +24,14 @@
 namespace re {
 namespace simd {
 
+// Independent accumulators a reduction keeps to hide the latency of the
+// vector add: about latency times the number of ports that can issue it.
+#if defined(RE_ARCH_AVX512) || defined(RE_ARCH_AVX)
+constexpr uint_t accumulators = 8;
+#else
+constexpr uint_t accumulators = 4;
+#endif
+
 template <typename T, typename BinaryOp, typename UnaryOp>
 struct apply
 {
@@ -37,6 +46,28 @@ struct apply
     }
 };
 
+// acc + x² as a single fused multiply-add.
+template <typename T>
+struct apply<T, intrinsics::add<T>, intrinsics::sqr<T>>
+{
+    T operator()(T a, T b) {
+        return intrinsics::mul_add<T>()(b, b, a);
+    }
+    lane<T> operator()(lane<T> a, lane<T> b) {
+        return intrinsics::mul_add<T>()(b, b, a);
+    }
+    T operator<<(lane<T> a) {
+        return intrinsics::add<T>() << a;
+    }
+};
+
+// Operation that merges the partial results of a reduction using op.
+template <typename Op>
+struct reduction_of { using type = Op; };
+
+template <typename T, typename BinaryOp, typename UnaryOp>
+struct reduction_of<apply<T, BinaryOp, UnaryOp>> { using type = BinaryOp; };
+
 
 
 template <
@@ -53,25 +84,35 @@ reduce_impl(
         ScalarT initial,
         SpanTs ...spans)
 {
-    auto firsts = std::make_tuple(std::begin(spans)...);
-    auto const lasts  = std::make_tuple(std::end(spans)...);
+    auto const firsts = std::make_tuple(std::data(spans)...);
+    auto const n = static_cast<int_t>(std::size(std::get<0>(std::tie(spans...))));
+    assert(((static_cast<int_t>(std::size(spans)) == n) && ...));
     auto state = set_lane(initial);
 
-    while (std::get<0>(firsts) != std::get<0>(lasts)) {
-        state = step(state, load(&(*std::get<I>(firsts)))...);
-        std::get<I...>(firsts) += width<ScalarT>;
+    int_t i = 0;
+    for (; i + width<ScalarT> <= n; i += width<ScalarT>) {
+        state = step(state, load(std::get<I>(firsts) + i)...);
+    }
+    auto const tail = n - i;
+    for (int_t j = 0; j < tail; ++j) {
+        state.a[0] = step(state.a[0], std::get<I>(firsts)[i + j]...);
     }
 
     return to_scalar(state);
 }
 
+// Folds any number of equally long spans in one pass with a single
+// accumulator. step(state, x...) is called with lanes of the spans and
+// then with the scalars left over, which are folded into the first element
+// of the state; to_scalar reduces the final state. Every element of the
+// state starts at `initial`, which should thus be neutral to step.
 template <typename StepFnT, typename ToScalarFnT, typename ScalarT, typename ...SpanTs>
 ScalarT reduce_scalar(StepFnT step, ToScalarFnT to_scalar, ScalarT initial, SpanTs ...spans)
 {
     return reduce_impl(
         std::index_sequence_for<SpanTs...>{},
-        to_scalar,
         step,
+        to_scalar,
         initial,
         spans...
     );
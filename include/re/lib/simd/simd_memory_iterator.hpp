@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
 #include <gsl/span>
 
 #include <re/lib/common.hpp>
@@ -8,7 +15,389 @@
 namespace re {
 namespace simd {
 
-template <typename T, uint_t N>
-class
+// Proxy to one lane worth of memory. Reading it loads the lane, assigning to
+// it stores one.
+template <typename T>
+class lane_ref
+{
+public:
+    using value_type = std::remove_const_t<T>;
+
+    explicit lane_ref(T* p)
+    noexcept :
+        p(p)
+    {
+    }
+
+    lane_ref(lane_ref const&) noexcept = default;
+
+    operator lane<value_type>()
+    const {
+        return get();
+    }
+
+    lane<value_type> get()
+    const {
+        return load(static_cast<value_type const*>(p));
+    }
+
+    lane_ref const& operator=(lane<value_type> value)
+    const {
+        static_assert(!std::is_const<T>::value, "lane is read-only");
+        store(p, value);
+        return *this;
+    }
+
+    lane_ref const& operator=(lane_ref const& rhs)
+    const {
+        return *this = rhs.get();
+    }
+
+    T* data()
+    const noexcept {
+        return p;
+    }
+
+private:
+    T* p;
+};
+
+// Steps through memory N lanes at a time. Dereferencing yields a lane_ref to
+// the first lane of the step, indexing yields the k-th lane of the step.
+template <typename T, uint_t N = 1>
+class simd_memory_iterator
+{
+public:
+    using value_type = lane<std::remove_const_t<T>>;
+    using reference = lane_ref<T>;
+    using difference_type = int_t;
+
+    static constexpr int_t lanes = static_cast<int_t>(N);
+    static constexpr int_t step = lanes * width<std::remove_const_t<T>>;
+
+    explicit simd_memory_iterator(T* p)
+    noexcept :
+        p(p)
+    {
+    }
+
+    reference operator*()
+    const noexcept {
+        return reference(p);
+    }
+
+    reference operator[](int_t k)
+    const noexcept {
+        assert(k >= 0 && k < lanes);
+        return reference(p + k * width<std::remove_const_t<T>>);
+    }
+
+    simd_memory_iterator& operator++()
+    noexcept {
+        p += step;
+        return *this;
+    }
+
+    simd_memory_iterator operator++(int)
+    noexcept {
+        auto ret = *this;
+        p += step;
+        return ret;
+    }
+
+    simd_memory_iterator& operator+=(difference_type n)
+    noexcept {
+        p += n * step;
+        return *this;
+    }
+
+    simd_memory_iterator operator+(difference_type n)
+    const noexcept {
+        auto ret = *this;
+        return ret += n;
+    }
+
+    difference_type operator-(simd_memory_iterator const& rhs)
+    const noexcept {
+        return (p - rhs.p) / step;
+    }
+
+    T* data()
+    const noexcept {
+        return p;
+    }
+
+    friend bool operator==(
+        simd_memory_iterator const& lhs,
+        simd_memory_iterator const& rhs
+    ) noexcept {
+        return lhs.p == rhs.p;
+    }
+
+    friend bool operator!=(
+        simd_memory_iterator const& lhs,
+        simd_memory_iterator const& rhs
+    ) noexcept {
+        return !(lhs == rhs);
+    }
+
+    friend bool operator<(
+        simd_memory_iterator const& lhs,
+        simd_memory_iterator const& rhs
+    ) noexcept {
+        return lhs.p < rhs.p;
+    }
+
+private:
+    T* p;
+};
+
+// Number of leading elements to handle one by one before p reaches the
+// alignment of a lane. Pointers that cannot be aligned are not peeled.
+template <typename T>
+int_t peel_size(T const* p, int_t n)
+noexcept {
+    constexpr auto a = alignof(vec_t<std::remove_const_t<T>>);
+    auto const misalignment = reinterpret_cast<std::uintptr_t>(p) % a;
+    if (misalignment == 0 || misalignment % sizeof(T) != 0) {
+        return 0;
+    }
+    return std::min(n, static_cast<int_t>((a - misalignment) / sizeof(T)));
+}
+
+// Walks several streams in lockstep, yielding tuples of lane_refs.
+template <uint_t N, typename... Ts>
+class zip_iterator
+{
+    using indices = std::index_sequence_for<Ts...>;
+
+public:
+    using reference = std::tuple<lane_ref<Ts>...>;
+    using difference_type = int_t;
+
+    explicit zip_iterator(simd_memory_iterator<Ts, N>... its)
+    noexcept :
+        its(its...)
+    {
+    }
+
+    reference operator*()
+    const noexcept {
+        return at(0);
+    }
+
+    reference operator[](int_t k)
+    const noexcept {
+        return at(k, indices{});
+    }
+
+    zip_iterator& operator++()
+    noexcept {
+        advance(indices{});
+        return *this;
+    }
+
+    friend bool operator==(zip_iterator const& lhs, zip_iterator const& rhs)
+    noexcept {
+        return std::get<0>(lhs.its) == std::get<0>(rhs.its);
+    }
+
+    friend bool operator!=(zip_iterator const& lhs, zip_iterator const& rhs)
+    noexcept {
+        return !(lhs == rhs);
+    }
+
+private:
+    reference at(int_t k)
+    const noexcept {
+        return at(k, indices{});
+    }
+
+    template <std::size_t... I>
+    reference at(int_t k, std::index_sequence<I...>)
+    const noexcept {
+        return reference(std::get<I>(its)[k]...);
+    }
+
+    template <std::size_t... I>
+    void advance(std::index_sequence<I...>)
+    noexcept {
+        (++std::get<I>(its), ...);
+    }
+
+    std::tuple<simd_memory_iterator<Ts, N>...> its;
+};
+
+// Zips spans of equal length into a sequence of lanes. The spans are split
+// into a scalar head that brings the first span to lane alignment, a body of
+// whole lanes walked N lanes per step, and a scalar tail.
+template <uint_t N, typename... Ts>
+class lane_range
+{
+    static_assert(sizeof...(Ts) > 0);
+    static_assert(N > 0);
+
+    using first_t = std::tuple_element_t<0, std::tuple<Ts...>>;
+    using value_t = std::remove_const_t<first_t>;
+    static_assert(
+        std::conjunction<std::is_same<value_t, std::remove_const_t<Ts>>...>::value,
+        "zipped spans must share their value type"
+    );
+    using indices = std::index_sequence_for<Ts...>;
+
+public:
+    using iterator = zip_iterator<N, Ts...>;
+
+    static constexpr int_t lane_width = width<value_t>;
+    static constexpr int_t step = static_cast<int_t>(N) * lane_width;
+
+    explicit lane_range(gsl::span<Ts>... spans)
+    noexcept :
+        data(spans.data()...),
+        n(first_size(spans...)),
+        head(peel_size(std::get<0>(data), n)),
+        body(head + (n - head) / step * step),
+        lane_end(head + (n - head) / lane_width * lane_width)
+    {
+        assert(((std::size(spans) == n) && ...));
+    }
+
+    int_t size()
+    const noexcept {
+        return n;
+    }
+
+    int_t head_size()
+    const noexcept {
+        return head;
+    }
+
+    // Body iterators cover whole steps of N lanes only.
+    iterator begin()
+    const noexcept {
+        return make_iterator(head, indices{});
+    }
+
+    iterator end()
+    const noexcept {
+        return make_iterator(body, indices{});
+    }
+
+    // Calls fn with element references for the head and tail and with
+    // lane_refs for the body, so one generic kernel covers the whole range.
+    template <typename Fn>
+    void for_each(Fn&& fn)
+    const {
+        for_each(fn, fn);
+    }
+
+    template <typename LaneFn, typename ScalarFn>
+    void for_each(LaneFn&& lane_fn, ScalarFn&& scalar_fn)
+    const {
+        int_t i = 0;
+        for (; i < head; ++i) {
+            apply_scalar(scalar_fn, i, indices{});
+        }
+        for (; i < body; i += step) {
+            apply_unrolled(lane_fn, i, std::make_index_sequence<N>{});
+        }
+        for (; i < lane_end; i += lane_width) {
+            apply_lane(lane_fn, i, indices{});
+        }
+        for (; i < n; ++i) {
+            apply_scalar(scalar_fn, i, indices{});
+        }
+    }
+
+    // Like for_each, but whole steps go to step_fn, which also receives the
+    // position of each lane within the step as a std::integral_constant.
+    // Per-lane state, such as independent accumulators, can be indexed by it
+    // and stays in registers.
+    template <typename StepFn, typename LaneFn, typename ScalarFn>
+    void for_each_step(
+        StepFn&& step_fn,
+        LaneFn&& lane_fn,
+        ScalarFn&& scalar_fn
+    ) const {
+        int_t i = 0;
+        for (; i < head; ++i) {
+            apply_scalar(scalar_fn, i, indices{});
+        }
+        for (; i < body; i += step) {
+            apply_indexed(step_fn, i, std::make_index_sequence<N>{});
+        }
+        for (; i < lane_end; i += lane_width) {
+            apply_lane(lane_fn, i, indices{});
+        }
+        for (; i < n; ++i) {
+            apply_scalar(scalar_fn, i, indices{});
+        }
+    }
+
+private:
+    template <typename S, typename... Rest>
+    static int_t first_size(S const& s, Rest const&...)
+    noexcept {
+        return std::size(s);
+    }
+
+    template <std::size_t... I>
+    iterator make_iterator(int_t offset, std::index_sequence<I...>)
+    const noexcept {
+        return iterator(
+            simd_memory_iterator<Ts, N>(std::get<I>(data) + offset)...
+        );
+    }
+
+    template <typename Fn, std::size_t... I>
+    void apply_scalar(Fn& fn, int_t offset, std::index_sequence<I...>)
+    const {
+        fn(std::get<I>(data)[offset]...);
+    }
+
+    template <typename Fn, std::size_t... I>
+    void apply_lane(Fn& fn, int_t offset, std::index_sequence<I...>)
+    const {
+        fn(lane_ref<Ts>(std::get<I>(data) + offset)...);
+    }
+
+    template <typename Fn, std::size_t... K>
+    void apply_unrolled(Fn& fn, int_t offset, std::index_sequence<K...>)
+    const {
+        (apply_lane(fn, offset + static_cast<int_t>(K) * lane_width, indices{}), ...);
+    }
+
+    template <typename Fn, std::size_t K, std::size_t... I>
+    void apply_lane_at(Fn& fn, int_t offset, std::index_sequence<I...>)
+    const {
+        fn(
+            std::integral_constant<std::size_t, K>{},
+            lane_ref<Ts>(std::get<I>(data) + offset)...
+        );
+    }
+
+    template <typename Fn, std::size_t... K>
+    void apply_indexed(Fn& fn, int_t offset, std::index_sequence<K...>)
+    const {
+        (apply_lane_at<Fn, K>(
+            fn,
+            offset + static_cast<int_t>(K) * lane_width,
+            indices{}
+        ), ...);
+    }
+
+    std::tuple<Ts*...> data;
+    int_t n;
+    int_t head;
+    int_t body;
+    int_t lane_end;
+};
+
+template <uint_t N = 1, typename... Ts, int_t... Extents>
+lane_range<N, Ts...> lanes(gsl::span<Ts, Extents>... spans)
+noexcept {
+    return lane_range<N, Ts...>(gsl::span<Ts>(spans)...);
+}
+
 }
 }
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include <re/lib/common.hpp>
+#include <re/lib/simd/simd.hpp>
+
+// Polynomial approximations of the elementary functions over whole lanes,
+// built only from the backend intrinsics so every backend gets them.
+//
+// Error bounds are the largest error against the exact result, in units in
+// the last place over the stated range, as measured on the x86 backends with
+// and without FMA. NaN inputs give unspecified results.
+
+namespace re {
+namespace simd {
+
+template <typename T> struct approximation;
+
+// Coefficients after Cephes (exp, sin, cos, atan) and FreeBSD msun (log).
+template <>
+struct approximation<float>
+{
+    static constexpr float log2e = 1.44269504088896341f;
+    static constexpr float ln2_hi = 0.693359375f;
+    static constexpr float ln2_lo = -2.12194440e-4f;
+    static constexpr float exp_max = 88.7228317f;
+    static constexpr float exp_min = -87.3365448f;
+    static constexpr std::array<float, 6> exp = {{
+        1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+        4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f
+    }};
+
+    static constexpr float log_ln2_hi = 6.9313812256e-01f;
+    static constexpr float log_ln2_lo = 9.0580006145e-06f;
+    static constexpr float log10_2_hi = 3.0102920532e-01f;
+    static constexpr float log10_2_lo = 7.9034151668e-07f;
+    static constexpr float log10_e = 4.3429449201e-01f;
+    static constexpr std::array<float, 4> log = {{
+        0.24279078841f, 0.28498786688f, 0.40000972152f, 0.66666662693f
+    }};
+
+    // pi/2 in four parts, the first three of 14 bits, so their products
+    // with the n of |x| < 1024 are exact.
+    static constexpr float pio2_1 = 1.57080078125f;
+    static constexpr float pio2_2 = -4.45451587438583374023e-6f;
+    static constexpr float pio2_3 = 6.07727201895613688976e-11f;
+    static constexpr float pio2_4 = -1.71512451000588187280e-15f;
+    static constexpr std::array<float, 3> sin = {{
+        -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f
+    }};
+    static constexpr std::array<float, 3> cos = {{
+        2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f
+    }};
+
+    static constexpr float atan_split = 0.4142135623730950f;
+    static constexpr std::array<float, 4> atan = {{
+        8.05374449538e-2f, -1.38776856032e-1f,
+        1.99777106478e-1f, -3.33329491539e-1f
+    }};
+};
+
+template <>
+struct approximation<double>
+{
+    static constexpr double log2e = 1.44269504088896340736;
+    static constexpr double ln2_hi = 6.93145751953125e-1;
+    static constexpr double ln2_lo = 1.42860682030941723212e-6;
+    static constexpr double exp_max = 709.782712893383973096;
+    static constexpr double exp_min = -708.396418532264106224;
+    // Taylor series, which is within an ulp on |r| <= ln(2)/2 at degree 13.
+    static constexpr std::array<double, 12> exp = {{
+        1. / 6227020800., 1. / 479001600., 1. / 39916800., 1. / 3628800.,
+        1. / 362880., 1. / 40320., 1. / 5040., 1. / 720.,
+        1. / 120., 1. / 24., 1. / 6., 1. / 2.
+    }};
+
+    static constexpr double log_ln2_hi = 6.93147180369123816490e-01;
+    static constexpr double log_ln2_lo = 1.90821492927058770002e-10;
+    static constexpr double log10_2_hi = 3.01029995663611771306e-01;
+    static constexpr double log10_2_lo = 3.69423907715893078616e-13;
+    static constexpr double log10_e = 4.34294481903251816668e-01;
+    static constexpr std::array<double, 7> log = {{
+        1.479819860511658591e-01, 1.531383769920937332e-01,
+        1.818357216161805012e-01, 2.222219843214978396e-01,
+        2.857142874366239149e-01, 3.999999999940941908e-01,
+        6.666666666666735130e-01
+    }};
+
+    // pi/2 in four parts, the first three of 33 bits, so their products
+    // with the n of |x| < 2^20 are exact.
+    static constexpr double pio2_1 = 1.57079632673412561417;
+    static constexpr double pio2_2 = 6.07710050630396597660e-11;
+    static constexpr double pio2_3 = 2.02226624871116645580e-21;
+    static constexpr double pio2_4 = 8.47842766036889956997e-32;
+    static constexpr std::array<double, 6> sin = {{
+        1.58962301576546568060e-10, -2.50507477628578072866e-8,
+        2.75573136213857245213e-6, -1.98412698295895385996e-4,
+        8.33333333332211858878e-3, -1.66666666666666307295e-1
+    }};
+    static constexpr std::array<double, 6> cos = {{
+        -1.13585365213876817300e-11, 2.08757008419747316778e-9,
+        -2.75573141792967388112e-7, 2.48015872888517045348e-5,
+        -1.38888888888730564116e-3, 4.16666666666665929218e-2
+    }};
+
+    // Rational approximation: the second polynomial is the denominator.
+    static constexpr double atan_split = 0.66;
+    static constexpr std::array<double, 5> atan = {{
+        -8.750608600031904122785e-1, -1.615753718733365076637e1,
+        -7.500855792314704667340e1, -1.228866684490136173410e2,
+        -6.485021904942025371773e1
+    }};
+    static constexpr std::array<double, 6> atan_q = {{
+        1., 2.485846490142306297962e1, 1.650270098316988542046e2,
+        4.328810604912902668951e2, 4.853903996359136964868e2,
+        1.945506571482613964425e2
+    }};
+};
+
+// Evaluates the polynomial with coefficients c, highest degree first.
+template <typename T, std::size_t N>
+inline lane<T> polynomial(lane<T> x, std::array<T, N> const& c) {
+    auto y = set_lane(c[0]);
+    for (auto i = 1u; i < N; ++i) {
+        y = intrinsics::mul_add<T>()(y, x, set_lane(c[i]));
+    }
+    return y;
+}
+
+template <typename T>
+inline lane<T> negate(lane<T> x) {
+    return subtract(intrinsics::zero<T>(), x);
+}
+
+template <typename T>
+inline lane<T> abs(lane<T> x) {
+    return intrinsics::max<T>()(x, negate(x));
+}
+
+// Mask of the elements of an integer valued lane that are odd.
+template <typename T>
+inline lane<T> is_odd(lane<T> n) {
+    auto const half = multiply(n, set_lane(T{0.5}));
+    auto const fraction = subtract(half, intrinsics::round<T>()(half));
+    return intrinsics::greater<T>()(abs(fraction), set_lane(T{0.25}));
+}
+
+// e^x. Results below the smallest normal number flush to zero.
+// float, double: 1.5 ulp.
+template <typename T>
+lane<T> exp(lane<T> x) {
+    using c = approximation<T>;
+    intrinsics::mul_add<T> mul_add;
+    intrinsics::select<T> select;
+
+    auto n = intrinsics::round<T>()(multiply(x, set_lane(c::log2e)));
+    auto r = mul_add(n, set_lane(-c::ln2_hi), x);
+    r = mul_add(n, set_lane(-c::ln2_lo), r);
+
+    auto const one = set_lane(T{1});
+    auto y = multiply(polynomial(r, c::exp), multiply(r, r));
+    y = add(add(y, r), one);
+
+    // 2^n stays normal for n up to max_exponent - 1, the last factor of two
+    // goes into y instead.
+    auto const positive = intrinsics::greater<T>()(n, intrinsics::zero<T>());
+    y = select(positive, add(y, y), y);
+    n = select(positive, subtract(n, one), n);
+    y = intrinsics::ldexp<T>()(y, n);
+
+    y = select(
+        intrinsics::greater<T>()(x, set_lane(c::exp_max)),
+        set_lane(std::numeric_limits<T>::infinity()),
+        y
+    );
+    return select(
+        intrinsics::less<T>()(x, set_lane(c::exp_min)),
+        intrinsics::zero<T>(),
+        y
+    );
+}
+
+// Splits positive x into 2^e * (1 + f) with 1 + f in [sqrt(2)/2, sqrt(2))
+// and returns log(1 + f).
+template <typename T>
+lane<T> log_reduce(lane<T> x, lane<T>& e) {
+    using c = approximation<T>;
+    using limits = std::numeric_limits<T>;
+    intrinsics::select<T> select;
+
+    // Subnormals are scaled into the normal range first.
+    auto const subnormal = intrinsics::less<T>()(x, set_lane(limits::min()));
+    auto const scale = static_cast<T>(std::size_t{1} << (limits::digits - 1));
+    x = select(subnormal, multiply(x, set_lane(scale)), x);
+
+    auto m = intrinsics::mantissa<T>()(x);
+    e = intrinsics::exponent<T>()(x);
+    e = select(subnormal, subtract(e, set_lane<T>(limits::digits - 1)), e);
+
+    auto const above = intrinsics::greater<T>()(m, set_lane(T{1.41421356237309504880}));
+    m = select(above, multiply(m, set_lane(T{0.5})), m);
+    e = select(above, add(e, set_lane(T{1})), e);
+
+    auto const f = subtract(m, set_lane(T{1}));
+    auto const s = divide(f, add(f, set_lane(T{2})));
+    auto const z = multiply(s, s);
+    auto const r = multiply(polynomial(z, c::log), z);
+    auto const hfsq = multiply(set_lane(T{0.5}), multiply(f, f));
+    return subtract(f, subtract(hfsq, multiply(s, add(hfsq, r))));
+}
+
+// Maps zero to -inf, negative numbers to NaN and +inf to itself.
+template <typename T>
+lane<T> log_special_cases(lane<T> x, lane<T> y) {
+    using limits = std::numeric_limits<T>;
+    intrinsics::select<T> select;
+
+    y = select(
+        intrinsics::greater<T>()(x, set_lane(limits::max())),
+        x,
+        y
+    );
+    y = select(
+        intrinsics::less<T>()(x, set_lane(limits::denorm_min())),
+        set_lane(-limits::infinity()),
+        y
+    );
+    return select(
+        intrinsics::less<T>()(x, intrinsics::zero<T>()),
+        set_lane(limits::quiet_NaN()),
+        y
+    );
+}
+
+// Natural logarithm, including subnormal inputs. float, double: 1.5 ulp.
+template <typename T>
+lane<T> log(lane<T> x) {
+    using c = approximation<T>;
+    intrinsics::mul_add<T> mul_add;
+
+    lane<T> e;
+    auto const log_m = log_reduce(x, e);
+    auto const y = mul_add(
+        e,
+        set_lane(c::log_ln2_hi),
+        mul_add(e, set_lane(c::log_ln2_lo), log_m)
+    );
+    return log_special_cases(x, y);
+}
+
+// Base 10 logarithm. float, double: 2 ulp.
+template <typename T>
+lane<T> log10(lane<T> x) {
+    using c = approximation<T>;
+    intrinsics::mul_add<T> mul_add;
+
+    lane<T> e;
+    auto const log_m = log_reduce(x, e);
+    auto const y = mul_add(
+        e,
+        set_lane(c::log10_2_hi),
+        mul_add(
+            e,
+            set_lane(c::log10_2_lo),
+            multiply(log_m, set_lane(c::log10_e))
+        )
+    );
+    return log_special_cases(x, y);
+}
+
+// Reduces x by the nearest multiple n of pi/2 and returns sin and cos of
+// the remainder, which lies within [-pi/4, pi/4].
+template <typename T>
+std::pair<lane<T>, lane<T>> sincos_reduce(lane<T> x, lane<T>& n) {
+    using c = approximation<T>;
+    intrinsics::mul_add<T> mul_add;
+
+    n = intrinsics::round<T>()(multiply(x, set_lane(T{2} / pi<T>)));
+    auto r = mul_add(n, set_lane(-c::pio2_1), x);
+    r = mul_add(n, set_lane(-c::pio2_2), r);
+    r = mul_add(n, set_lane(-c::pio2_3), r);
+    r = mul_add(n, set_lane(-c::pio2_4), r);
+
+    auto const z = multiply(r, r);
+    auto const sine = mul_add(multiply(r, z), polynomial(z, c::sin), r);
+    auto const cosine = add(
+        mul_add(z, set_lane(T{-0.5}), set_lane(T{1})),
+        multiply(multiply(z, z), polynomial(z, c::cos))
+    );
+    return {sine, cosine};
+}
+
+// Sine and cosine of x, sharing the argument reduction.
+// float: 2.5 ulp for |x| <= 1000, double: 2.5 ulp for |x| <= 2^20, about
+// half of it from rounding the remainder at each step of the reduction.
+// Beyond that the reduction by pi/2 loses accuracy, first near the zeros.
+template <typename T>
+std::pair<lane<T>, lane<T>> sincos(lane<T> x) {
+    intrinsics::select<T> select;
+
+    lane<T> n;
+    auto const reduced = sincos_reduce(x, n);
+
+    // The quadrant n mod 4 decides which approximation is used and its sign.
+    auto const swap = is_odd(n);
+    auto const quarter = set_lane(T{0.25});
+    auto const half = set_lane(T{0.5});
+    auto const sin_negative = is_odd(intrinsics::round<T>()(
+        subtract(multiply(n, half), quarter)
+    ));
+    auto const cos_negative = is_odd(intrinsics::round<T>()(
+        subtract(multiply(add(n, set_lane(T{1})), half), quarter)
+    ));
+
+    auto s = select(swap, reduced.second, reduced.first);
+    auto c = select(swap, reduced.first, reduced.second);
+    s = select(sin_negative, negate(s), s);
+    c = select(cos_negative, negate(c), c);
+    return {s, c};
+}
+
+// float: 2.5 ulp for |x| <= 1000, double: 2.5 ulp for |x| <= 2^20.
+template <typename T>
+lane<T> sin(lane<T> x) {
+    return sincos(x).first;
+}
+
+// float: 2.5 ulp for |x| <= 1000, double: 2.5 ulp for |x| <= 2^20.
+template <typename T>
+lane<T> cos(lane<T> x) {
+    return sincos(x).second;
+}
+
+// Angle of the point (x, y), in [-pi, pi]. Signs of zeros are ignored, so
+// atan2(0, 0) is 0 and atan2(+-0, x < 0) is pi. At most one argument may be
+// infinite. float: 3 ulp, double: 2 ulp.
+template <typename T>
+lane<T> atan2(lane<T> y, lane<T> x) {
+    using c = approximation<T>;
+    intrinsics::mul_add<T> mul_add;
+    intrinsics::select<T> select;
+    intrinsics::greater<T> greater;
+    intrinsics::less<T> less;
+
+    auto const ax = abs(x);
+    auto const ay = abs(y);
+    auto const hi = intrinsics::max<T>()(ax, ay);
+    auto const lo = intrinsics::min<T>()(ax, ay);
+
+    // atan(lo/hi) = pi/4 + atan((lo - hi) / (lo + hi)) keeps the argument
+    // of the approximation small.
+    auto const shifted = greater(lo, multiply(hi, set_lane(c::atan_split)));
+    auto t = divide(
+        select(shifted, subtract(lo, hi), lo),
+        select(shifted, add(lo, hi), hi)
+    );
+    t = select(greater(hi, intrinsics::zero<T>()), t, intrinsics::zero<T>());
+
+    auto const z = multiply(t, t);
+    auto p = polynomial(z, c::atan);
+    if constexpr (std::is_same<T, double>::value) {
+        p = divide(p, polynomial(z, c::atan_q));
+    }
+    auto a = mul_add(multiply(t, z), p, t);
+    a = select(shifted, add(a, set_lane(pi<T> / 4)), a);
+
+    a = select(greater(ay, ax), subtract(set_lane(pi<T> / 2), a), a);
+    a = select(less(x, intrinsics::zero<T>()), subtract(set_lane(pi<T>), a), a);
+    return select(less(y, intrinsics::zero<T>()), negate(a), a);
+}
+
+// x^y for positive x, as e^(y log x). The rounding error of the product
+// is scaled by its magnitude: about 1 + 1.5 |y log x| ulp.
+template <typename T>
+lane<T> pow(lane<T> x, lane<T> y) {
+    return exp(multiply(y, log(x)));
+}
+
+}
+}
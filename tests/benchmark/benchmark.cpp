@@ -18,18 +18,40 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <complex>
+#include <mutex>
+#include <cstdint>
+#include <functional>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include <gsl/span>
 
+#include <re/lib/container/dynamic_ring.hpp>
+#include <re/lib/container/mirrored_ring.hpp>
 #include <re/lib/container/revolver.hpp>
+#include <re/lib/container/ring_array.hpp>
+#include <re/lib/container/sliding_aggregate.hpp>
+#include <re/lib/container/sliding_percentile.hpp>
+#include <re/lib/container/spsc_ring.hpp>
+#include <re/lib/math/adaptive_threshold.hpp>
+#include <re/lib/math/beat_tracker.hpp>
+#include <re/lib/math/biquad.hpp>
+#include <re/lib/math/comb_filter.hpp>
+#include <re/lib/math/expression.hpp>
+#include <re/lib/math/normalize.hpp>
+#include <re/lib/math/onset_picker.hpp>
+#include <re/lib/math/pcm.hpp>
+#include <re/lib/math/peaks.hpp>
 #include <re/lib/math/reductions.hpp>
 #include <re/lib/fft/fft.hpp>
 #include <re/lib/fft/simd_fft.hpp>
+#include <re/lib/simd/aligned.hpp>
+#include <re/lib/simd/transcendental.hpp>
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
@@ -91,23 +113,31 @@ static void std_mean_1024f(benchmark::State& state) {
 }
 BENCHMARK(std_mean_1024f);
 
+template <uint_t Accumulators>
 static void mean_1024f(benchmark::State& state) {
     std::array<float, 1024> input;
     fill_sin(gsl::span<float, 1024>(input));
     while (state.KeepRunning()) {
-        input[0] = mean(gsl::span<float const, 1024>(input));
+        input[0] = mean<Accumulators>(gsl::span<float const, 1024>(input));
     }
 }
-BENCHMARK(mean_1024f);
+BENCHMARK_TEMPLATE(mean_1024f, 1);
+BENCHMARK_TEMPLATE(mean_1024f, 4);
+BENCHMARK_TEMPLATE(mean_1024f, 8);
 
+template <uint_t Accumulators>
 static void sum_of_squares_1024f(benchmark::State& state) {
     std::array<float, 1024> input;
     fill_sin(gsl::span<float, 1024>(input));
     while (state.KeepRunning()) {
-        input[0] = sum_of_squares(gsl::span<float const, 1024>(input));
+        input[0] = sum_of_squares<Accumulators>(
+            gsl::span<float const, 1024>(input)
+        );
     }
 }
-BENCHMARK(sum_of_squares_1024f);
+BENCHMARK_TEMPLATE(sum_of_squares_1024f, 1);
+BENCHMARK_TEMPLATE(sum_of_squares_1024f, 4);
+BENCHMARK_TEMPLATE(sum_of_squares_1024f, 8);
 
 static void std_mean_1024d(benchmark::State& state) {
     std::array<double, 1024> input;
@@ -122,21 +152,295 @@ static void std_mean_1024d(benchmark::State& state) {
 }
 BENCHMARK(std_mean_1024d);
 
+template <uint_t Accumulators>
 static void mean_1024d(benchmark::State& state) {
     std::array<double, 1024> input;
     fill_sin(gsl::span<double, 1024>(input));
     while (state.KeepRunning()) {
-        input[0] = mean(gsl::span<double const, 1024>(input));
+        input[0] = mean<Accumulators>(gsl::span<double const, 1024>(input));
     }
 }
-BENCHMARK(mean_1024d);
+BENCHMARK_TEMPLATE(mean_1024d, 1);
+BENCHMARK_TEMPLATE(mean_1024d, 8);
+
+static void dot_1024f(benchmark::State& state) {
+    std::array<float, 1024> a;
+    std::array<float, 1024> b;
+    fill_sin(gsl::span<float, 1024>(a));
+    fill_sin(gsl::span<float, 1024>(b));
+    while (state.KeepRunning()) {
+        auto const d = dot(
+            gsl::span<float const, 1024>(a),
+            gsl::span<float const, 1024>(b)
+        );
+        benchmark::DoNotOptimize(d);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(dot_1024f);
+
+static void std_inner_product_1024f(benchmark::State& state) {
+    std::array<float, 1024> a;
+    std::array<float, 1024> b;
+    fill_sin(gsl::span<float, 1024>(a));
+    fill_sin(gsl::span<float, 1024>(b));
+    while (state.KeepRunning()) {
+        auto const d = std::inner_product(
+            std::cbegin(a),
+            std::cend(a),
+            std::cbegin(b),
+            0.f
+        );
+        benchmark::DoNotOptimize(d);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(std_inner_product_1024f);
+
+static void correlation_1024f(benchmark::State& state) {
+    std::array<float, 1024> a;
+    std::array<float, 1024> b;
+    fill_sin(gsl::span<float, 1024>(a));
+    fill_sin(gsl::span<float, 1024>(b));
+    while (state.KeepRunning()) {
+        auto const r = correlation(
+            gsl::span<float const, 1024>(a),
+            gsl::span<float const, 1024>(b)
+        );
+        benchmark::DoNotOptimize(r);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(correlation_1024f);
+
+static void expression_1024f(benchmark::State& state) {
+    std::array<float, 1024> a;
+    std::array<float, 1024> b;
+    std::array<float, 1024> out;
+    fill_sin(gsl::span<float, 1024>(a));
+    fill_sin(gsl::span<float, 1024>(b));
+    while (state.KeepRunning()) {
+        assign(
+            gsl::span<float, 1024>(out),
+            clamp(
+                lazy(gsl::span<float const, 1024>(a)) * 2.f
+                    - lazy(gsl::span<float const, 1024>(b)),
+                0.f,
+                1.f
+            )
+        );
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(expression_1024f);
+
+static void separate_passes_1024f(benchmark::State& state) {
+    std::array<float, 1024> a;
+    std::array<float, 1024> b;
+    std::array<float, 1024> out;
+    fill_sin(gsl::span<float, 1024>(a));
+    fill_sin(gsl::span<float, 1024>(b));
+    while (state.KeepRunning()) {
+        std::transform(
+            std::cbegin(a), std::cend(a), std::begin(out),
+            [] (float x) { return x * 2.f; }
+        );
+        benchmark::ClobberMemory();
+        std::transform(
+            std::cbegin(out), std::cend(out), std::cbegin(b), std::begin(out),
+            std::minus<float>()
+        );
+        benchmark::ClobberMemory();
+        std::transform(
+            std::cbegin(out), std::cend(out), std::begin(out),
+            [] (float x) { return std::min(std::max(x, 0.f), 1.f); }
+        );
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(separate_passes_1024f);
+
+static void fill_pcm(gsl::span<std::int16_t> pcm) {
+    for (auto i = 0; i < std::size(pcm); ++i) {
+        pcm[i] = static_cast<std::int16_t>(32767 * sin_n(i, std::size(pcm)));
+    }
+}
+
+static void deinterleave_stereo_1024(benchmark::State& state) {
+    std::vector<std::int16_t> pcm(2 * 1024);
+    std::array<float, 1024> left;
+    std::array<float, 1024> right;
+    fill_pcm(pcm);
+    while (state.KeepRunning()) {
+        deinterleave(
+            gsl::span<std::int16_t const>(pcm),
+            std::array<gsl::span<float, 1024>, 2>{{left, right}}
+        );
+        benchmark::DoNotOptimize(left.data());
+        benchmark::DoNotOptimize(right.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(deinterleave_stereo_1024);
+
+static void scalar_deinterleave_stereo_1024(benchmark::State& state) {
+    std::vector<std::int16_t> pcm(2 * 1024);
+    std::array<float, 1024> left;
+    std::array<float, 1024> right;
+    fill_pcm(pcm);
+    while (state.KeepRunning()) {
+        for (auto i = 0u; i < left.size(); ++i) {
+            left[i] = pcm[2 * i] / 32768.f;
+            right[i] = pcm[2 * i + 1] / 32768.f;
+        }
+        benchmark::DoNotOptimize(left.data());
+        benchmark::DoNotOptimize(right.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(scalar_deinterleave_stereo_1024);
+
+static void downmix_5ch_1024(benchmark::State& state) {
+    std::vector<std::int16_t> pcm(5 * 1024);
+    std::array<float, 1024> mono;
+    fill_pcm(pcm);
+    while (state.KeepRunning()) {
+        downmix(
+            gsl::span<std::int16_t const>(pcm),
+            std::array<float, 5>{{.2f, .2f, .2f, .2f, .2f}},
+            gsl::span<float, 1024>(mono)
+        );
+        benchmark::DoNotOptimize(mono.data());
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(downmix_5ch_1024);
+
+static void argmax_1024f(benchmark::State& state) {
+    std::array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    while (state.KeepRunning()) {
+        auto const m = math::max(gsl::span<float const, 1024>(input));
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(argmax_1024f);
+
+static void std_max_element_1024f(benchmark::State& state) {
+    std::array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    while (state.KeepRunning()) {
+        auto const m = std::max_element(std::cbegin(input), std::cend(input));
+        benchmark::DoNotOptimize(m);
+    }
+}
+BENCHMARK(std_max_element_1024f);
+
+static void exp_1024f(benchmark::State& state) {
+    simd::aligned_array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    simd::aligned_array<float, 1024> output;
+    while (state.KeepRunning()) {
+        for (auto i = 0; i < 1024; i += simd::width<float>) {
+            simd::store_aligned(
+                output.data() + i,
+                simd::exp(simd::load_aligned(input.data() + i))
+            );
+        }
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(exp_1024f);
+
+static void std_exp_1024f(benchmark::State& state) {
+    std::array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    std::array<float, 1024> output;
+    while (state.KeepRunning()) {
+        std::transform(
+            std::cbegin(input),
+            std::cend(input),
+            std::begin(output),
+            [](float x) { return std::exp(x); }
+        );
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(std_exp_1024f);
+
+static void sincos_1024f(benchmark::State& state) {
+    simd::aligned_array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    simd::aligned_array<float, 1024> sines;
+    simd::aligned_array<float, 1024> cosines;
+    while (state.KeepRunning()) {
+        for (auto i = 0; i < 1024; i += simd::width<float>) {
+            auto const sc = simd::sincos(simd::load_aligned(input.data() + i));
+            simd::store_aligned(sines.data() + i, sc.first);
+            simd::store_aligned(cosines.data() + i, sc.second);
+        }
+        benchmark::DoNotOptimize(sines);
+        benchmark::DoNotOptimize(cosines);
+    }
+}
+BENCHMARK(sincos_1024f);
+
+static void std_sincos_1024f(benchmark::State& state) {
+    std::array<float, 1024> input;
+    fill_sin(gsl::span<float, 1024>(input));
+    std::array<float, 1024> sines;
+    std::array<float, 1024> cosines;
+    while (state.KeepRunning()) {
+        for (auto i = 0; i < 1024; ++i) {
+            sines[i] = std::sin(input[i]);
+            cosines[i] = std::cos(input[i]);
+        }
+        benchmark::DoNotOptimize(sines);
+        benchmark::DoNotOptimize(cosines);
+    }
+}
+BENCHMARK(std_sincos_1024f);
+
+static void log10_1024f(benchmark::State& state) {
+    simd::aligned_array<float, 1024> input;
+    std::iota(std::begin(input), std::end(input), 1.f);
+    simd::aligned_array<float, 1024> output;
+    while (state.KeepRunning()) {
+        for (auto i = 0; i < 1024; i += simd::width<float>) {
+            simd::store_aligned(
+                output.data() + i,
+                simd::log10(simd::load_aligned(input.data() + i))
+            );
+        }
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(log10_1024f);
+
+static void std_log10_1024f(benchmark::State& state) {
+    std::array<float, 1024> input;
+    std::iota(std::begin(input), std::end(input), 1.f);
+    std::array<float, 1024> output;
+    while (state.KeepRunning()) {
+        std::transform(
+            std::cbegin(input),
+            std::cend(input),
+            std::begin(output),
+            [](float x) { return std::log10(x); }
+        );
+        benchmark::DoNotOptimize(output);
+    }
+}
+BENCHMARK(std_log10_1024f);
 
 static void BM_FFT_float_512cpx_bi_direct(benchmark::State& state) {
-    std::array<std::complex<float>, 256> __attribute__((aligned (16))) input;
+    simd::aligned_array<std::complex<float>, 256> input;
     input.fill(0);
     input[1] = 1;
 
-    std::array<std::complex<float>, 256> __attribute__((aligned (16))) output;
+    simd::aligned_array<std::complex<float>, 256> output;
     fft::simd_fft<float, 256> fft;
 
     while (state.KeepRunning()) {
@@ -148,6 +452,696 @@ BENCHMARK(BM_FFT_float_512cpx_bi_direct);
 
 
 
+// One hop of 128 new samples followed by a sum over the whole window, as an
+// STFT would read it.
+static void ring_array_hop_1024f(benchmark::State& state) {
+    ring_array<float, 1024> ring;
+    std::array<float, 128> hop;
+    fill_sin(gsl::span<float, 128>(hop));
+    while (state.KeepRunning()) {
+        ring.append(gsl::span<float const, 128>(hop));
+        auto const& window = ring.linearize();
+        auto const s = sum(gsl::span<float const, 1024>(window));
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(ring_array_hop_1024f);
+
+static void ring_array_segments_hop_1024f(benchmark::State& state) {
+    ring_array<float, 1024> ring;
+    std::array<float, 128> hop;
+    fill_sin(gsl::span<float, 128>(hop));
+    while (state.KeepRunning()) {
+        ring.append(gsl::span<float const, 128>(hop));
+        auto s = 0.f;
+        for (auto segment : std::as_const(ring).segments()) {
+            s += sum(segment);
+        }
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(ring_array_segments_hop_1024f);
+
+static void mirrored_ring_hop_1024f(benchmark::State& state) {
+    mirrored_ring<float, 1024> ring;
+    std::array<float, 128> hop;
+    fill_sin(gsl::span<float, 128>(hop));
+    while (state.KeepRunning()) {
+        ring.append(gsl::span<float const, 128>(hop));
+        auto const s = sum(ring.window());
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(mirrored_ring_hop_1024f);
+
+// Handing one 128 sample block over and taking it back out, on one thread
+// so only the cost of the handoff itself is measured.
+static void spsc_ring_handoff_128f(benchmark::State& state) {
+    spsc_ring<float, 1024> ring;
+    std::array<float, 128> block;
+    fill_sin(gsl::span<float, 128>(block));
+    while (state.KeepRunning()) {
+        ring.write(gsl::span<float const>(block));
+        ring.read(gsl::span<float>(block));
+        benchmark::DoNotOptimize(block.data());
+    }
+}
+BENCHMARK(spsc_ring_handoff_128f);
+
+static void locked_ring_array_handoff_128f(benchmark::State& state) {
+    std::mutex mutex;
+    ring_array<float, 1024> ring;
+    std::array<float, 128> block;
+    fill_sin(gsl::span<float, 128>(block));
+    while (state.KeepRunning()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ring.append(gsl::span<float const, 128>(block));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::copy(std::cend(ring) - 128, std::cend(ring), std::begin(block));
+        }
+        benchmark::DoNotOptimize(block.data());
+    }
+}
+BENCHMARK(locked_ring_array_handoff_128f);
+
+// Pushing one sample into histories of different lengths costs the same.
+static void revolver_push_back(benchmark::State& state) {
+    revolver<std::vector<float>> ring(
+        std::vector<float>(static_cast<std::size_t>(state.range(0)))
+    );
+    auto x = 0.f;
+    while (state.KeepRunning()) {
+        ring.push_back(x);
+        x += 1.f;
+        benchmark::DoNotOptimize(ring.back());
+    }
+}
+BENCHMARK(revolver_push_back)->Arg(64)->Arg(1024)->Arg(16384);
+
+static void revolver_insert_middle(benchmark::State& state) {
+    revolver<std::vector<float>> ring(
+        std::vector<float>(static_cast<std::size_t>(state.range(0)))
+    );
+    auto const middle = ring.cbegin() + state.range(0) / 2;
+    while (state.KeepRunning()) {
+        ring.insert(middle, 1.f);
+        benchmark::DoNotOptimize(ring.back());
+    }
+}
+BENCHMARK(revolver_insert_middle)->Arg(64)->Arg(1024)->Arg(16384);
+
+static void dynamic_ring_push_back(benchmark::State& state) {
+    dynamic_ring<float> ring(static_cast<std::size_t>(state.range(0)));
+    auto x = 0.f;
+    while (state.KeepRunning()) {
+        ring.push_back(x);
+        x += 1.f;
+        benchmark::DoNotOptimize(ring.back());
+    }
+}
+BENCHMARK(dynamic_ring_push_back)->Arg(64)->Arg(1000)->Arg(16384);
+
+// A hop into a history whose length is not a power of two, read back
+// through its segments.
+static void dynamic_ring_segments_hop_1000f(benchmark::State& state) {
+    dynamic_ring<float> ring(1000);
+    std::array<float, 128> hop;
+    fill_sin(gsl::span<float, 128>(hop));
+    while (state.KeepRunning()) {
+        ring.append(gsl::span<float const, 128>(hop));
+        auto s = 0.f;
+        for (auto segment : std::as_const(ring).segments()) {
+            s += sum(segment);
+        }
+        benchmark::DoNotOptimize(s);
+    }
+}
+BENCHMARK(dynamic_ring_segments_hop_1000f);
+
+// Local mean, spread and peak of a window after every new sample.
+static void sliding_aggregate_push(benchmark::State& state) {
+    sliding_aggregate<float> window(static_cast<std::size_t>(state.range(0)));
+    auto x = 0.f;
+    while (state.KeepRunning()) {
+        window.push_back(std::sin(x));
+        x += 0.1f;
+        benchmark::DoNotOptimize(window.mean());
+        benchmark::DoNotOptimize(window.variance());
+        benchmark::DoNotOptimize(window.max());
+    }
+}
+BENCHMARK(sliding_aggregate_push)->Arg(16)->Arg(256)->Arg(4096);
+
+static void rescanned_window_push(benchmark::State& state) {
+    dynamic_ring<float> window(static_cast<std::size_t>(state.range(0)));
+    auto x = 0.f;
+    while (state.KeepRunning()) {
+        window.push_back(std::sin(x));
+        x += 0.1f;
+        auto const n = static_cast<float>(window.size());
+        auto const mean = std::accumulate(
+            std::cbegin(window),
+            std::cend(window),
+            0.f
+        ) / n;
+        auto const variance = std::accumulate(
+            std::cbegin(window),
+            std::cend(window),
+            0.f,
+            [mean] (auto s, auto v) { return s + (v - mean) * (v - mean); }
+        ) / n;
+        benchmark::DoNotOptimize(mean);
+        benchmark::DoNotOptimize(variance);
+        benchmark::DoNotOptimize(
+            *std::max_element(std::cbegin(window), std::cend(window))
+        );
+    }
+}
+BENCHMARK(rescanned_window_push)->Arg(16)->Arg(256)->Arg(4096);
+
+// Median thresholds of 1024 novelty values, by sorting every
+// neighbourhood and by the sliding windows.
+template <int_t Radius>
+static void sorted_neighbourhoods_median_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    std::array<float, 2*Radius + 1> window;
+    while (state.KeepRunning()) {
+        for (int_t i = 0; i < 1024; ++i) {
+            for (int_t j = -Radius; j <= Radius; ++j) {
+                auto const k = std::min(std::max(i + j, int_t{0}), int_t{1023});
+                window[j + Radius] = in[k];
+            }
+            std::nth_element(
+                std::begin(window),
+                std::begin(window) + Radius,
+                std::end(window)
+            );
+            out[i] = std::fdim(in[i], window[Radius]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK_TEMPLATE(sorted_neighbourhoods_median_1024f, 4);
+BENCHMARK_TEMPLATE(sorted_neighbourhoods_median_1024f, 7);
+BENCHMARK_TEMPLATE(sorted_neighbourhoods_median_1024f, 16);
+BENCHMARK_TEMPLATE(sorted_neighbourhoods_median_1024f, 128);
+
+template <int_t Radius>
+static void median_threshold_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        median_threshold<Radius>(
+            gsl::span<float const, 1024>(in),
+            gsl::span<float, 1024>(out)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK_TEMPLATE(median_threshold_1024f, 4);
+BENCHMARK_TEMPLATE(median_threshold_1024f, 7);
+BENCHMARK_TEMPLATE(median_threshold_1024f, 16);
+BENCHMARK_TEMPLATE(median_threshold_1024f, 128);
+
+static void heap_median_threshold_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        percentile_threshold(
+            gsl::span<float const, 1024>(in),
+            gsl::span<float, 1024>(out),
+            state.range(0),
+            0.5
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(heap_median_threshold_1024f)->Arg(4)->Arg(7)->Arg(16)->Arg(128);
+
+// Mean thresholds of 4096 novelty values, by summing every window and
+// by prefix sums, in one call and in blocks of 256 as they arrive.
+static void threshold_reference_4096f(benchmark::State& state) {
+    std::array<float, 4096> in, out, thresh;
+    fill_sin(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        threshold_reference(
+            gsl::span<float const, 4096>(in),
+            gsl::span<float, 4096>(out),
+            gsl::span<float, 4096>(thresh),
+            state.range(0)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(threshold_reference_4096f)->Arg(4)->Arg(16)->Arg(64)->Arg(512);
+
+static void adaptive_threshold_4096f(benchmark::State& state) {
+    std::array<float, 4096> in, out;
+    fill_sin(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        adaptive_threshold(
+            gsl::span<float const, 4096>(in),
+            gsl::span<float, 4096>(out),
+            state.range(0)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(adaptive_threshold_4096f)->Arg(4)->Arg(16)->Arg(64)->Arg(512);
+
+static void streaming_threshold_push_256f(benchmark::State& state) {
+    std::array<float, 256> in, out;
+    fill_sin(gsl::span<float, 256>(in));
+    streaming_threshold<float> threshold(state.range(0));
+    while (state.KeepRunning()) {
+        threshold.push(
+            gsl::span<float const>(in),
+            gsl::span<float>(out)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(streaming_threshold_push_256f)->Arg(4)->Arg(16)->Arg(64)->Arg(512);
+
+// Combs of 256 and 512 periods over 4096 novelty values, 16 and 8 stages
+// of multiples.
+template <int_t N_out>
+static void comb_filter_reference_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    std::array<float, N_out> out;
+    fill_sin(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        comb_filter_reference(
+            gsl::span<float const, 4096>(in),
+            gsl::span<float, N_out>(out)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK_TEMPLATE(comb_filter_reference_4096f, 256);
+BENCHMARK_TEMPLATE(comb_filter_reference_4096f, 512);
+
+template <int_t N_out>
+static void comb_filter_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    std::array<float, N_out> out;
+    fill_sin(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        comb_filter(
+            gsl::span<float const, 4096>(in),
+            gsl::span<float, N_out>(out)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK_TEMPLATE(comb_filter_4096f, 256);
+BENCHMARK_TEMPLATE(comb_filter_4096f, 512);
+
+// 400 periods 1.5 samples apart.
+static void comb_filter_fractional_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    std::array<float, 400> out;
+    fill_sin(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        comb_filter(
+            gsl::span<float const>(in),
+            gsl::span<float>(out),
+            1.5
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(comb_filter_fractional_4096f);
+
+// The 511 periods of comb_filter_4096f<512> as a bank, scored and ranked.
+static void comb_filter_bank_best_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_sin(gsl::span<float, 4096>(in));
+    std::vector<double> periods(511);
+    std::iota(std::begin(periods), std::end(periods), 1.);
+    comb_filter_bank<float> bank(4096, periods, 8);
+    std::array<element<float>, 8> best;
+    while (state.KeepRunning()) {
+        bank.best(
+            gsl::span<float const, 4096>(in),
+            gsl::span<element<float>, 8>(best)
+        );
+        benchmark::DoNotOptimize(best.data());
+    }
+}
+BENCHMARK(comb_filter_bank_best_4096f);
+
+// 400 periods 1.5 samples apart, so that half the window ends fall
+// inside a sample.
+static void comb_filter_bank_fractional_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_sin(gsl::span<float, 4096>(in));
+    std::vector<double> periods(399);
+    for (auto i = 0u; i < periods.size(); ++i) {
+        periods[i] = 1.5 * (i + 1);
+    }
+    comb_filter_bank<float> bank(4096, periods, 6, 1.5);
+    std::array<float, 399> out;
+    while (state.KeepRunning()) {
+        bank.score(
+            gsl::span<float const, 4096>(in),
+            gsl::span<float, 399>(out)
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(comb_filter_bank_fractional_4096f);
+
+static void normalize_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        normalize(gsl::span<float const, 1024>(in), gsl::span<float, 1024>(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(normalize_1024f);
+
+static void std_normalize_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        auto const sum = std::accumulate(
+            std::cbegin(in),
+            std::cend(in),
+            0.f,
+            [] (float result, float value) {
+                return result + std::fmax(value, 0.f);
+            }
+        );
+        std::transform(
+            std::cbegin(in),
+            std::cend(in),
+            std::begin(out),
+            [sum] (float v) { return v / sum; }
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(std_normalize_1024f);
+
+static void softmax_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        softmax(gsl::span<float const, 1024>(in), gsl::span<float, 1024>(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(softmax_1024f);
+
+static void std_softmax_1024f(benchmark::State& state) {
+    std::array<float, 1024> in, out;
+    fill_sin(gsl::span<float, 1024>(in));
+    while (state.KeepRunning()) {
+        auto const top = *std::max_element(std::cbegin(in), std::cend(in));
+        auto sum = 0.f;
+        for (auto i = 0; i < 1024; ++i) {
+            out[i] = std::exp(in[i] - top);
+            sum += out[i];
+        }
+        for (auto& v : out) {
+            v /= sum;
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(std_softmax_1024f);
+
+// 64 spectra of 513 bins.
+static void standardize_rows_64x513f(benchmark::State& state) {
+    std::vector<float> in(64 * 513), out(in.size());
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = sin_n(static_cast<int_t>(i % 513), 513) * (i / 513 + 1);
+    }
+    while (state.KeepRunning()) {
+        normalize_rows(
+            gsl::span<float const>(in),
+            gsl::span<float>(out),
+            513,
+            [] (auto row_in, auto row_out) { standardize(row_in, row_out); }
+        );
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(standardize_rows_64x513f);
+
+// The 8 strongest of the many peaks of a spectrum of 4096 bins, 25
+// harmonics over a floor of noise.
+static void fill_noisy_spectrum(gsl::span<float, 4096> spectrum) {
+    for (auto i = 0; i < 4096; ++i) {
+        spectrum[i] = static_cast<float>((i * 7919) % 61) / 61.f;
+        auto const harmonic = (i + 80) / 160;
+        auto const d = std::abs(i - 160 * harmonic);
+        if (harmonic > 0 && d < 3) {
+            spectrum[i] += (2.f + harmonic % 7) * (3 - d) / 3;
+        }
+    }
+}
+
+static void find_peaks_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_noisy_spectrum(gsl::span<float, 4096>(in));
+    while (state.KeepRunning()) {
+        auto const peaks = find_peaks<8>(
+            gsl::span<float const, 4096>(in),
+            state.range(0)
+        );
+        benchmark::DoNotOptimize(peaks);
+    }
+}
+BENCHMARK(find_peaks_4096f)->Arg(1)->Arg(8);
+
+static void std_find_peaks_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_noisy_spectrum(gsl::span<float, 4096>(in));
+    std::vector<element<float>> peaks;
+    while (state.KeepRunning()) {
+        peaks.clear();
+        for (auto i = 1; i < 4095; ++i) {
+            if (in[i] > in[i - 1] && in[i] >= in[i + 1]) {
+                peaks.emplace_back(in[i], static_cast<std::size_t>(i));
+            }
+        }
+        std::partial_sort(
+            std::begin(peaks),
+            std::begin(peaks) + std::min<std::size_t>(8, peaks.size()),
+            std::end(peaks),
+            [] (auto const& a, auto const& b) { return a.value > b.value; }
+        );
+        benchmark::DoNotOptimize(peaks.data());
+    }
+}
+BENCHMARK(std_find_peaks_4096f);
+
+// Onsets of 4096 frames of novelty, pushed a frame at a time, against the
+// windows taken afresh for every frame, averaging over the given number of
+// frames before each.
+template <typename Window>
+static void onset_picker_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_noisy_spectrum(gsl::span<float, 4096>(in));
+    peak_picking<float> settings;
+    settings.delta = 0.1f;
+    settings.pre_average = state.range(0);
+    while (state.KeepRunning()) {
+        onset_picker<float, Window> picker(settings);
+        int_t count = 0;
+        for (auto x : in) {
+            count += picker.push(x).has_value();
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK_TEMPLATE(onset_picker_4096f, window_mean<float>)->Arg(10)->Arg(100);
+BENCHMARK_TEMPLATE(onset_picker_4096f, window_median<float>)
+    ->Arg(10)
+    ->Arg(100);
+
+static void std_onset_picker_4096f(benchmark::State& state) {
+    std::array<float, 4096> in;
+    fill_noisy_spectrum(gsl::span<float, 4096>(in));
+    peak_picking<float> settings;
+    settings.delta = 0.1f;
+    settings.pre_average = state.range(0);
+    while (state.KeepRunning()) {
+        int_t count = 0;
+        int_t last = -settings.wait - 1;
+        for (int_t i = 0; i + 1 < 4096; ++i) {
+            auto const lo = std::max(i - settings.pre_max, int_t{0});
+            auto const hi = std::min(i + settings.post_max + 1, int_t{4096});
+            auto const highest = *std::max_element(&in[lo], &in[0] + hi);
+            auto const from = std::max(i - settings.pre_average, int_t{0});
+            auto const to = i + settings.post_average + 1;
+            auto const mean = std::accumulate(&in[from], &in[0] + to, 0.f)
+                / (settings.pre_average + settings.post_average + 1);
+            if (in[i] == highest
+                && in[i] >= mean + settings.delta
+                && i - last > settings.wait) {
+                last = i;
+                ++count;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(std_onset_picker_4096f)->Arg(10)->Arg(100);
+
+// Beats of three minutes of novelty at 86 frames a second, a beat every 43
+// frames over noise.
+static void fill_novelty(gsl::span<float> novelty) {
+    for (auto i = 0; i < std::size(novelty); ++i) {
+        novelty[i] = static_cast<float>((i * 7919) % 61) / 61.f
+            + (i % 43 == 5 ? 4.f : 0.f);
+    }
+}
+
+static void track_beats_16384f(benchmark::State& state) {
+    std::vector<float> in(16384);
+    fill_novelty(gsl::span<float>(in));
+    beat_transition<float> const window(43);
+    while (state.KeepRunning()) {
+        auto const beats = track_beats(gsl::span<float const>(in), window);
+        benchmark::DoNotOptimize(beats.data());
+    }
+}
+BENCHMARK(track_beats_16384f);
+
+static void std_track_beats_16384f(benchmark::State& state) {
+    std::vector<float> in(16384);
+    fill_novelty(gsl::span<float>(in));
+    beat_transition<float> const window(43);
+    auto const lo = window.nearest();
+    auto const hi = window.farthest();
+    auto const n = static_cast<int_t>(std::size(in));
+    std::vector<float> scores(n);
+    std::vector<int_t> links(n);
+    while (state.KeepRunning()) {
+        for (int_t i = 0; i < n; ++i) {
+            auto best = -std::numeric_limits<float>::infinity();
+            int_t link = -1;
+            for (auto p = std::max(i - hi, int_t{0}); p <= i - lo; ++p) {
+                auto const candidate = scores[p] + window.weights()[p - i + hi];
+                if (candidate > best) {
+                    best = candidate;
+                    link = p;
+                }
+            }
+            scores[i] = in[i] + (link < 0 ? 0.f : best);
+            links[i] = link;
+        }
+        std::vector<int_t> beats;
+        auto b = static_cast<int_t>(std::max_element(
+            std::end(scores) - 43,
+            std::end(scores)
+        ) - std::begin(scores));
+        for (; b >= 0; b = links[b]) {
+            beats.push_back(b);
+        }
+        std::reverse(std::begin(beats), std::end(beats));
+        benchmark::DoNotOptimize(beats.data());
+    }
+}
+BENCHMARK(std_track_beats_16384f);
+
+static void beat_tracker_push_256f(benchmark::State& state) {
+    std::vector<float> in(16384);
+    fill_novelty(gsl::span<float>(in));
+    std::array<int_t, 256> out;
+    beat_tracker<float> tracker(beat_transition<float>(43));
+    int_t i = 0;
+    while (state.KeepRunning()) {
+        auto const written = tracker.push(
+            gsl::span<float const>(in.data() + i, 256),
+            gsl::span<int_t>(out)
+        );
+        benchmark::DoNotOptimize(written);
+        i = (i + 256) % 16384;
+    }
+}
+BENCHMARK(beat_tracker_push_256f);
+
+// Banks of 8 to 64 band-pass filters of two sections each, spread over
+// the spectrum, on 4096 samples of a chirp.
+static void fill_chirp(gsl::span<float> signal) {
+    for (auto i = 0; i < std::size(signal); ++i) {
+        signal[i] = std::sin(1e-4f * i * i);
+    }
+}
+
+static biquad_bank<float> band_bank(int_t bands) {
+    biquad_bank<float> bank(bands, 2);
+    for (int_t f = 0; f < bands; ++f) {
+        auto const frequency = 0.45 * (f + 1) / (bands + 1);
+        bank.set(f, 0, biquad<float>::bandpass(frequency, 4));
+        bank.set(f, 1, biquad<float>::bandpass(frequency, 4));
+    }
+    return bank;
+}
+
+static void biquad_bank_split_4096f(benchmark::State& state) {
+    auto const bands = state.range(0);
+    auto bank = band_bank(bands);
+    std::vector<float> in(4096), out(4096 * bands);
+    fill_chirp(gsl::span<float>(in));
+    while (state.KeepRunning()) {
+        bank.split(gsl::span<float const>(in), gsl::span<float>(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(biquad_bank_split_4096f)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
+static void biquad_bank_process_4096f(benchmark::State& state) {
+    auto const channels = state.range(0);
+    auto bank = band_bank(channels);
+    std::vector<float> in(4096 * channels), out(4096 * channels);
+    fill_chirp(gsl::span<float>(in));
+    while (state.KeepRunning()) {
+        bank.process(gsl::span<float const>(in), gsl::span<float>(out));
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(biquad_bank_process_4096f)->Arg(8)->Arg(64);
+
+static void std_biquad_bank_split_4096f(benchmark::State& state) {
+    auto const bands = state.range(0);
+    std::vector<biquad<float>> sections;
+    for (int_t f = 0; f < bands; ++f) {
+        auto const frequency = 0.45 * (f + 1) / (bands + 1);
+        sections.push_back(biquad<float>::bandpass(frequency, 4));
+    }
+    std::vector<float> in(4096), out(4096 * bands);
+    std::vector<float> s(4 * bands, 0.f);
+    fill_chirp(gsl::span<float>(in));
+    while (state.KeepRunning()) {
+        for (int_t f = 0; f < bands; ++f) {
+            auto const& c = sections[f];
+            auto* z = s.data() + 4 * f;
+            for (int_t t = 0; t < 4096; ++t) {
+                auto x = in[t];
+                for (int_t k = 0; k < 2; ++k) {
+                    auto const y = c.b0 * x + z[2*k];
+                    z[2*k] = c.b1 * x - c.a1 * y + z[2*k + 1];
+                    z[2*k + 1] = c.b2 * x - c.a2 * y;
+                    x = y;
+                }
+                out[t * bands + f] = x;
+            }
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(std_biquad_bank_split_4096f)->Arg(8)->Arg(16)->Arg(32)->Arg(64);
+
 static void mean_1024ld(benchmark::State& state) {
     std::array<long double, 1024> input;
     fill_sin(gsl::span<long double, 1024>(input));
@@ -0,0 +1,540 @@
+// Copyright (c) 2016 Roman Beránek. All rights reserved.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gsl/span>
+#include <re/lib/container/broadcast_ring.hpp>
+#include <re/lib/container/dynamic_ring.hpp>
+#include <re/lib/container/mirrored_ring.hpp>
+#include <re/lib/container/revolver.hpp>
+#include <re/lib/container/ring_array.hpp>
+#include <re/lib/container/sliding_aggregate.hpp>
+#include <re/lib/container/sliding_percentile.hpp>
+#include <re/lib/container/spsc_ring.hpp>
+
+namespace re {
+
+class ContainerTest : public ::testing::Test {
+protected:
+    ContainerTest() {
+
+    }
+
+    virtual ~ContainerTest () {
+
+    }
+
+    virtual void SetUp() {
+
+    }
+
+    virtual void TearDown() {
+
+    }
+};
+
+// Feeds the same stream to the ring and to a deque of the last Size values,
+// in chunks of varying length, and checks every window against it.
+template <typename Ring>
+void expect_mirrors_stream(Ring& ring) {
+    auto const size = static_cast<std::ptrdiff_t>(ring.size());
+    std::deque<float> expected(size, 0.f);
+    std::vector<float> stream(10 * size);
+    std::iota(std::begin(stream), std::end(stream), 1.f);
+
+    auto first = std::cbegin(stream);
+    for (auto chunk = 0; first != std::cend(stream); chunk = (chunk + 7) % 23) {
+        auto const n = std::min<std::ptrdiff_t>(
+            chunk == 0 ? 3 * size : chunk,
+            std::cend(stream) - first
+        );
+        if (n == 1) {
+            ring.push_back(*first);
+        } else {
+            ring.append(gsl::span<float const>(&*first, n));
+        }
+        for (auto i = 0; i < n; ++i) {
+            expected.pop_front();
+            expected.push_back(first[i]);
+        }
+        first += n;
+
+        auto const window = ring.window();
+        ASSERT_TRUE(std::equal(
+            std::cbegin(window),
+            std::cend(window),
+            std::cbegin(expected)
+        ));
+        auto const tail = ring.last(5);
+        EXPECT_TRUE(std::equal(
+            std::cbegin(tail),
+            std::cend(tail),
+            std::cend(expected) - 5
+        ));
+        EXPECT_EQ(expected.front(), ring.front());
+        EXPECT_EQ(expected.back(), ring.back());
+    }
+}
+
+TEST_F(ContainerTest, MirroredRingKeepsLastValuesContiguous) {
+    mirrored_ring<float, 37, duplicated_buffer<float, 37>> duplicated;
+    expect_mirrors_stream(duplicated);
+
+#ifdef RE_HAS_MIRRORED_MAPPING
+    mirrored_ring<float, 1024, mirrored_mapping<float, 1024>> mapped;
+    expect_mirrors_stream(mapped);
+
+    // Not a whole number of pages, so the capacity exceeds the window.
+    mirrored_ring<float, 1000, mirrored_mapping<float, 1000>> padded;
+    expect_mirrors_stream(padded);
+
+    auto copy = padded;
+    EXPECT_TRUE(std::equal(
+        std::cbegin(copy.window()),
+        std::cend(copy.window()),
+        std::cbegin(padded.window())
+    ));
+#endif
+}
+
+TEST_F(ContainerTest, RingArrayAppendsInBlocks) {
+    constexpr auto size = 37;
+    ring_array<int, size> ring;
+    ring.fill(0);
+    std::deque<int> expected(size, 0);
+    std::vector<int> stream(10 * size);
+    std::iota(std::begin(stream), std::end(stream), 1);
+
+    auto first = std::cbegin(stream);
+    for (auto n : {5, 32, 1, 0, 36, 37, 80, 2, 19, 40}) {
+        ring.append(gsl::span<int const>(&*first, n));
+        for (auto i = 0; i < n; ++i) {
+            expected.pop_front();
+            expected.push_back(first[i]);
+        }
+        first += n;
+
+        EXPECT_TRUE(std::equal(
+            std::cbegin(ring),
+            std::cend(ring),
+            std::cbegin(expected)
+        ));
+
+        auto const segments = std::as_const(ring).segments();
+        EXPECT_EQ(size, std::size(segments[0]) + std::size(segments[1]));
+        EXPECT_TRUE(std::equal(
+            std::cbegin(segments[0]),
+            std::cend(segments[0]),
+            std::cbegin(expected)
+        ));
+        EXPECT_TRUE(std::equal(
+            std::cbegin(segments[1]),
+            std::cend(segments[1]),
+            std::cbegin(expected) + std::size(segments[0])
+        ));
+    }
+}
+
+TEST_F(ContainerTest, SpscRingHandsOverStreamInOrder) {
+    constexpr auto total = 200000;
+    spsc_ring<int, 100> ring;
+
+    std::thread producer([&ring] {
+        std::vector<int> chunk(37);
+        auto next = 0;
+        auto size = 1;
+        while (next < total) {
+            if (ring.writable() == 0) {
+                std::this_thread::yield();
+            }
+            size = size % 37 + 1;
+            auto const n = std::min(size, total - next);
+            if (size % 2 == 0) {
+                std::iota(std::begin(chunk), std::begin(chunk) + n, next);
+                next += ring.write(gsl::span<int const>(chunk.data(), n));
+            } else {
+                auto left = n;
+                for (auto region : ring.prepare()) {
+                    auto const m = std::min<std::ptrdiff_t>(
+                        left,
+                        std::size(region)
+                    );
+                    std::iota(std::begin(region), std::begin(region) + m, next);
+                    next += m;
+                    left -= m;
+                    ring.commit(m);
+                }
+            }
+        }
+    });
+
+    std::vector<int> received;
+    std::vector<int> chunk(29);
+    auto size = 1;
+    while (received.size() < total) {
+        if (ring.readable() == 0) {
+            std::this_thread::yield();
+        }
+        size = size % 29 + 1;
+        if (size % 3 == 0) {
+            auto const n = ring.read(gsl::span<int>(chunk.data(), size));
+            received.insert(
+                std::end(received),
+                std::begin(chunk),
+                std::begin(chunk) + n
+            );
+        } else {
+            for (auto region : ring.peek()) {
+                received.insert(
+                    std::end(received),
+                    std::cbegin(region),
+                    std::cend(region)
+                );
+                ring.consume(std::size(region));
+            }
+        }
+    }
+    producer.join();
+
+    std::vector<int> expected(total);
+    std::iota(std::begin(expected), std::end(expected), 0);
+    EXPECT_EQ(expected, received);
+}
+
+TEST_F(ContainerTest, BroadcastRingServesEveryReaderWholeStream) {
+    constexpr auto total = 100000;
+    constexpr auto readers = 3u;
+    broadcast_ring<int, 256, readers> ring;
+
+    std::array<std::vector<int>, readers> received;
+    std::vector<std::thread> threads;
+    for (auto k = 0u; k < readers; ++k) {
+        threads.emplace_back([&ring, &received, k] {
+            auto& out = received[k];
+            std::vector<int> chunk(64);
+            auto const hop = static_cast<std::size_t>(16 << k);
+            while (out.size() < total) {
+                if (ring.readable(k) < hop && ring.backlog(k) < hop) {
+                    std::this_thread::yield();
+                }
+                if (k == 0) {
+                    auto const n = ring.read(k, gsl::span<int>(chunk));
+                    out.insert(
+                        std::end(out),
+                        std::begin(chunk),
+                        std::begin(chunk) + n
+                    );
+                    continue;
+                }
+                auto left = std::min(hop, ring.readable(k));
+                for (auto region : ring.peek(k)) {
+                    auto const n = std::min<std::size_t>(left, std::size(region));
+                    out.insert(
+                        std::end(out),
+                        std::cbegin(region),
+                        std::cbegin(region) + n
+                    );
+                    left -= n;
+                }
+                ring.consume(k, std::min(hop, ring.readable(k)));
+            }
+        });
+    }
+
+    std::vector<int> block(40);
+    for (auto next = 0; next < total;) {
+        auto const n = std::min<int>(std::size(block), total - next);
+        std::iota(std::begin(block), std::begin(block) + n, next);
+        auto const written = ring.write(gsl::span<int const>(block.data(), n));
+        if (written == 0) {
+            std::this_thread::yield();
+        }
+        next += written;
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> expected(total);
+    std::iota(std::begin(expected), std::end(expected), 0);
+    for (auto const& out : received) {
+        EXPECT_EQ(expected, out);
+    }
+    EXPECT_EQ(0u, ring.dropped());
+}
+
+TEST_F(ContainerTest, BroadcastRingCountsWhatSlowestReaderForcesToDrop) {
+    broadcast_ring<int, 8, 2> ring;
+    std::array<int, 6> block{{1, 2, 3, 4, 5, 6}};
+    std::array<int, 8> out;
+
+    EXPECT_EQ(6u, ring.push(gsl::span<int const>(block)));
+    EXPECT_EQ(6u, ring.read(0, gsl::span<int>(out)));
+    EXPECT_EQ(2u, ring.push(gsl::span<int const>(block)));
+    EXPECT_EQ(4u, ring.dropped());
+    EXPECT_EQ(2u, ring.backlog(0));
+    EXPECT_EQ(8u, ring.backlog(1));
+
+    EXPECT_EQ(8u, ring.read(1, gsl::span<int>(out)));
+    EXPECT_EQ((std::array<int, 8>{{1, 2, 3, 4, 5, 6, 1, 2}}), out);
+}
+
+// Reference model of revolver: every operation rotates a plain vector.
+class rotating_history {
+public:
+    explicit rotating_history(std::vector<int> values) :
+        v(std::move(values))
+    {
+    }
+
+    void push_back(int x) {
+        v.front() = x;
+        std::rotate(std::begin(v), std::begin(v) + 1, std::end(v));
+    }
+
+    void push_front(int x) {
+        v.back() = x;
+        std::rotate(std::begin(v), std::end(v) - 1, std::end(v));
+    }
+
+    void insert(std::ptrdiff_t d, int x) {
+        if (d > 0) {
+            v.front() = x;
+            std::rotate(std::begin(v), std::begin(v) + 1, std::begin(v) + d);
+        }
+    }
+
+    void rinsert(std::ptrdiff_t d, int x) {
+        auto const n = static_cast<std::ptrdiff_t>(v.size());
+        if (d < n) {
+            v.back() = x;
+            std::rotate(std::begin(v) + d, std::end(v) - 1, std::end(v));
+        }
+    }
+
+    std::vector<int> v;
+};
+
+template <typename C>
+void expect_rotating_history(C container) {
+    revolver<C> ring(container);
+    rotating_history expected(
+        std::vector<int>(std::begin(container), std::end(container))
+    );
+    auto const n = static_cast<int>(ring.size());
+
+    std::vector<int> values(2 * n);
+    for (auto step = 0; step < 200; ++step) {
+        auto const d = (step * 7) % (n + 1);
+        auto const x = 1000 + step;
+        auto const k = (step * 5) % (2 * n);
+        std::iota(std::begin(values), std::end(values), x);
+
+        switch (step % 8) {
+        case 0:
+            ring.push_back(x);
+            expected.push_back(x);
+            break;
+        case 1:
+            ring.push_front(x);
+            expected.push_front(x);
+            break;
+        case 2:
+            ring.insert(ring.cbegin() + d, x);
+            expected.insert(d, x);
+            break;
+        case 3:
+            ring.rinsert(ring.cbegin() + d, x);
+            expected.rinsert(d, x);
+            break;
+        case 4:
+            ring.insert(ring.cbegin() + d, k, x);
+            for (auto i = 0; i < std::min(d, k); ++i) {
+                expected.insert(d, x);
+            }
+            break;
+        case 5:
+            ring.rinsert(ring.cbegin() + d, k, x);
+            for (auto i = 0; i < std::min(n - d, k); ++i) {
+                expected.rinsert(d, x);
+            }
+            break;
+        case 6:
+            ring.insert(
+                ring.cbegin() + d,
+                std::cbegin(values),
+                std::cbegin(values) + k
+            );
+            for (auto i = 0; i < k; ++i) {
+                expected.insert(d, values[i]);
+            }
+            break;
+        case 7:
+            ring.rinsert(
+                ring.cbegin() + d,
+                std::cbegin(values),
+                std::cbegin(values) + k
+            );
+            for (auto i = 0; i < k; ++i) {
+                expected.rinsert(d, values[i]);
+            }
+            break;
+        }
+        ASSERT_TRUE(std::equal(
+            std::cbegin(ring),
+            std::cend(ring),
+            std::cbegin(expected.v)
+        )) << "step " << step;
+    }
+
+    auto const segments = ring.segments();
+    EXPECT_TRUE(std::equal(
+        std::cbegin(segments[0]),
+        std::cend(segments[0]),
+        std::cbegin(expected.v)
+    ));
+    EXPECT_TRUE(std::equal(
+        std::cbegin(expected.v),
+        std::cend(expected.v),
+        ring.data()
+    ));
+}
+
+TEST_F(ContainerTest, RevolverMatchesRotatingHistory) {
+    expect_rotating_history(std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+    expect_rotating_history(std::array<int, 9>{{1, 2, 3, 4, 5, 6, 7, 8, 9}});
+}
+
+TEST_F(ContainerTest, DynamicRingKeepsLastValues) {
+    for (auto size : {1, 5, 16, 100}) {
+        dynamic_ring<int> ring(static_cast<std::size_t>(size));
+        EXPECT_EQ(static_cast<std::size_t>(size), ring.size());
+        EXPECT_EQ(0u, ring.capacity() & (ring.capacity() - 1));
+
+        std::deque<int> expected(size, 0);
+        std::vector<int> values(300);
+        std::iota(std::begin(values), std::end(values), 1);
+        auto first = std::cbegin(values);
+        for (auto n : {1, 3, 150, 0, 7, 64, 1, 2, 70}) {
+            if (n == 1) {
+                ring.push_back(*first);
+            } else {
+                ring.append(gsl::span<int const>(&*first, n));
+            }
+            for (auto i = 0; i < n; ++i) {
+                expected.pop_front();
+                expected.push_back(first[i]);
+            }
+            first += n;
+
+            EXPECT_TRUE(std::equal(
+                std::cbegin(ring),
+                std::cend(ring),
+                std::cbegin(expected)
+            ));
+            auto const segments = std::as_const(ring).segments();
+            std::vector<int> joined(
+                std::cbegin(segments[0]),
+                std::cend(segments[0])
+            );
+            joined.insert(
+                std::end(joined),
+                std::cbegin(segments[1]),
+                std::cend(segments[1])
+            );
+            EXPECT_TRUE(std::equal(
+                std::cbegin(joined),
+                std::cend(joined),
+                std::cbegin(expected),
+                std::cend(expected)
+            ));
+            EXPECT_EQ(expected.back(), ring.back());
+        }
+    }
+}
+
+TEST_F(ContainerTest, SlidingAggregateMatchesWindowStatistics) {
+    std::vector<double> values(500);
+    for (auto i = 0u; i < values.size(); ++i) {
+        values[i] = 1e6 + std::sin(0.37 * i) * (i % 13) - 0.01 * (i % 7);
+    }
+
+    for (auto length : {1u, 2u, 7u, 64u}) {
+        sliding_aggregate<double> window(length);
+        for (auto i = 0u; i < values.size(); ++i) {
+            window.push_back(values[i]);
+
+            auto const first = std::cbegin(values)
+                + (i + 1 > length ? i + 1 - length : 0);
+            auto const last = std::cbegin(values) + i + 1;
+            auto const n = static_cast<double>(last - first);
+            auto const mean = std::accumulate(first, last, 0.) / n;
+            auto const variance = std::accumulate(
+                first,
+                last,
+                0.,
+                [mean] (auto s, auto x) { return s + (x - mean) * (x - mean); }
+            ) / n;
+
+            ASSERT_EQ(static_cast<std::size_t>(n), window.size());
+            EXPECT_NEAR(mean * n, window.sum(), 1e-6);
+            EXPECT_NEAR(mean, window.mean(), 1e-8);
+            EXPECT_NEAR(variance, window.variance(), 1e-6);
+            EXPECT_EQ(*std::min_element(first, last), window.min());
+            EXPECT_EQ(*std::max_element(first, last), window.max());
+        }
+    }
+}
+
+// The order statistic window against sorting the last values, on a stream
+// with plenty of repeated values.
+TEST_F(ContainerTest, SlidingPercentileMatchesSortedWindow) {
+    constexpr auto length = 9u;
+    std::vector<float> values(400);
+    for (auto i = 0u; i < values.size(); ++i) {
+        values[i] = static_cast<float>((i * 7919u) % 23u) - 11.f;
+    }
+
+    for (auto rank : {0u, 2u, 4u, 8u}) {
+        sliding_percentile<float> window(length, rank, 1.f);
+        std::deque<float> last(length, 1.f);
+        for (auto x : values) {
+            window.push_back(x);
+            last.pop_front();
+            last.push_back(x);
+
+            std::vector<float> expected(std::cbegin(last), std::cend(last));
+            std::sort(std::begin(expected), std::end(expected));
+            ASSERT_EQ(expected[rank], window.value());
+        }
+    }
+}
+
+} // namespace re
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
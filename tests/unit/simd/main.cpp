@@ -15,8 +15,34 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
+
 #include <gsl/span>
+#include <re/lib/fft/fft.hpp>
+#include <re/lib/fft/real_fft.hpp>
+#include <re/lib/fft/simd_fft.hpp>
+#include <re/lib/math/adaptive_threshold.hpp>
+#include <re/lib/math/beat_tracker.hpp>
+#include <re/lib/math/biquad.hpp>
+#include <re/lib/math/comb_filter.hpp>
+#include <re/lib/math/expression.hpp>
+#include <re/lib/math/normalize.hpp>
+#include <re/lib/math/onset_picker.hpp>
+#include <re/lib/math/pcm.hpp>
+#include <re/lib/math/peaks.hpp>
+#include <re/lib/math/prefix_sum.hpp>
 #include <re/lib/math/reductions.hpp>
+#include <re/lib/simd/aligned.hpp>
+#include <re/lib/simd/simd_memory_iterator.hpp>
+#include <re/lib/simd/transcendental.hpp>
 
 namespace re {
 using namespace simd;
@@ -47,6 +73,1313 @@ TEST_F(SimdTest, Whatever) {
     EXPECT_TRUE(true);
 }
 
+TEST_F(SimdTest, ArgMaxMatchesMaxElement) {
+    std::vector<float> input(1021);
+    for (auto i = 0u; i < input.size(); ++i) {
+        input[i] = std::sin(0.37f * i) * static_cast<float>(i % 13);
+    }
+
+    for (auto n : {1, 2, 7, 16, 17, 100, 1021}) {
+        gsl::span<float const> span(input.data(), n);
+        auto const expected_max = std::max_element(span.begin(), span.end());
+        auto const expected_min = std::min_element(span.begin(), span.end());
+
+        auto const max = math::max(span);
+        EXPECT_EQ(*expected_max, max.value);
+        EXPECT_EQ(expected_max - span.begin(), max.index);
+
+        auto const min = math::min(span);
+        EXPECT_EQ(*expected_min, min.value);
+        EXPECT_EQ(expected_min - span.begin(), min.index);
+    }
+}
+
+TEST_F(SimdTest, ArgMaxPrefersFirstOfEqualElements) {
+    std::vector<double> input(64, 1.);
+    input[40] = 3.;
+    input[9] = 3.;
+    input[33] = 3.;
+
+    auto const max = math::max(gsl::span<double const>(input));
+    EXPECT_EQ(3., max.value);
+    EXPECT_EQ(9u, max.index);
+}
+
+TEST_F(SimdTest, ArgMaxKeepsIndexPastFloatPrecision) {
+    // Past 2^28 a float only holds multiples of 32, so the offset of the
+    // best chunk would round if it were not counted per segment.
+    int_t const n = (int_t{1} << 28) + 64;
+    int_t const target = (int_t{1} << 28) + width<float> + 3;
+    auto const value_at = [=] (int_t i) {
+        return i == target ? 2.f : i == 5 ? 1.f : 0.f;
+    };
+
+    auto const max = math::arg_reduce<float>(
+        n,
+        intrinsics::greater<float>(),
+        [&] (int_t i) {
+            auto x = intrinsics::zero<float>();
+            if (i + width<float> > 5 && i <= target) {
+                for (auto j = 0; j < width<float>; ++j) {
+                    x.a[j] = value_at(i + j);
+                }
+            }
+            return x;
+        },
+        value_at
+    );
+    EXPECT_EQ(2.f, max.value);
+    EXPECT_EQ(static_cast<std::size_t>(target), max.index);
+}
+
+TEST_F(SimdTest, MaxResultFusesBinaryOp) {
+    std::vector<float> a(77);
+    std::vector<float> b(77);
+    for (auto i = 0u; i < a.size(); ++i) {
+        a[i] = std::cos(0.11f * i);
+        b[i] = static_cast<float>(i % 5);
+    }
+
+    auto const result = math::max_result(
+        gsl::span<float const>(a),
+        gsl::span<float const>(b),
+        intrinsics::mul<float>()
+    );
+    auto const expected = math::max_result(
+        std::cbegin(a),
+        std::cend(a),
+        std::cbegin(b),
+        std::multiplies<float>()
+    );
+    EXPECT_EQ(expected.value, result.value);
+    EXPECT_EQ(expected.index, result.index);
+}
+
+TEST_F(SimdTest, AlignedStorage) {
+    constexpr auto n = 2 * width<float>;
+    aligned_array<float, n> array;
+    EXPECT_TRUE(is_aligned(array.data()));
+    for (auto i = 0; i < n; ++i) {
+        array[i] = static_cast<float>(i);
+    }
+
+    for (auto size : {1, 3, 17, 1000}) {
+        aligned_vector<double> vector(size);
+        EXPECT_TRUE(is_aligned(vector.data()));
+    }
+
+    // A lane loaded from the aligned start comes back one value on.
+    auto const first = load_aligned(array.data());
+    for (auto j = 0; j < width<float>; ++j) {
+        EXPECT_EQ(static_cast<float>(j), first.a[j]);
+    }
+    store(array.data() + 1, first);
+    EXPECT_EQ(0.f, array[0]);
+    for (auto j = 0; j < width<float>; ++j) {
+        EXPECT_EQ(static_cast<float>(j), array[j + 1]);
+    }
+    for (auto i = width<float> + 1; i < n; ++i) {
+        EXPECT_EQ(static_cast<float>(i), array[i]);
+    }
+}
+
+TEST_F(SimdTest, LaneRangeCoversHeadBodyAndTail) {
+    aligned_vector<float> a(203);
+    aligned_vector<float> b(203);
+    aligned_vector<float> out(203, 0.f);
+    for (auto i = 0u; i < a.size(); ++i) {
+        a[i] = static_cast<float>(i);
+        b[i] = 0.5f * static_cast<float>(i);
+    }
+
+    for (auto offset : {0, 1, 3}) {
+        auto const n = 200 - offset;
+        auto range = lanes<2>(
+            gsl::span<float const>(a.data() + offset, n),
+            gsl::span<float const>(b.data() + offset, n),
+            gsl::span<float>(out.data() + offset, n)
+        );
+        EXPECT_EQ(n, range.size());
+
+        range.for_each([] (auto x, auto y, auto&& z) {
+            z = intrinsics::add<float>()(x, y);
+        });
+        for (auto i = offset; i < offset + n; ++i) {
+            EXPECT_EQ(1.5f * static_cast<float>(i), out[i]);
+        }
+    }
+}
+
+TEST_F(SimdTest, LaneRangeIteratesBody) {
+    aligned_vector<double> data(67, 1.);
+    auto range = lanes(gsl::span<double>(data));
+
+    for (auto [x] : range) {
+        x = intrinsics::add<double>()(x, x);
+    }
+    auto const body = (data.size() / width<double>) * width<double>;
+    for (auto i = 0u; i < data.size(); ++i) {
+        EXPECT_EQ(i < body ? 2. : 1., data[i]);
+    }
+}
+
+TEST_F(SimdTest, ReduceHandlesRemainders) {
+    std::vector<float> input(131);
+    std::iota(input.begin(), input.end(), 1.f);
+    for (auto offset : {0, 1, 2, 5}) {
+        for (auto n : {1, 7, 8, 9, 33, 126}) {
+            gsl::span<float const> span(input.data() + offset, n);
+            EXPECT_EQ(
+                std::accumulate(span.begin(), span.end(), 0.f),
+                math::sum(span)
+            );
+        }
+    }
+}
+
+TEST_F(SimdTest, FftMatchesNaiveDft) {
+    constexpr auto N = 64;
+    aligned_array<std::complex<float>, N> input;
+    aligned_array<float, N> real_input;
+    for (auto i = 0; i < N; ++i) {
+        input[i] = {std::sin(0.3f * i * i), std::cos(0.7f * i)};
+        real_input[i] = input[i].real();
+    }
+
+    std::array<std::complex<double>, N> expected;
+    std::array<std::complex<double>, N/2 + 1> expected_real;
+    for (auto k = 0; k < N; ++k) {
+        std::complex<double> acc = 0, acc_real = 0;
+        for (auto n = 0; n < N; ++n) {
+            auto const w = std::polar(1., -2. * M_PI * k * n / N);
+            acc += std::complex<double>(input[n]) * w;
+            acc_real += static_cast<double>(real_input[n]) * w;
+        }
+        expected[k] = acc;
+        if (k <= N/2) {
+            expected_real[k] = acc_real;
+        }
+    }
+
+    aligned_array<std::complex<float>, N> output;
+    fft::fft<float, N, fft::direction::forward>{}(input, output);
+    for (auto k = 0; k < N; ++k) {
+        EXPECT_NEAR(0., std::abs(expected[k] - std::complex<double>(output[k])), 1e-4);
+    }
+
+    fft::simd_fft<float, N> simd_fft;
+    simd_fft(input, output);
+    for (auto k = 0; k < N; ++k) {
+        EXPECT_NEAR(0., std::abs(expected[k] - std::complex<double>(output[k])), 1e-4);
+    }
+
+    std::array<std::complex<float>, N/2 + 1> real_output;
+    fft::real_fft<float, N, fft::direction::forward>{}(real_input, real_output);
+    for (auto k = 0; k <= N/2; ++k) {
+        EXPECT_NEAR(0., std::abs(expected_real[k] - std::complex<double>(real_output[k])), 1e-4);
+    }
+}
+
+// The transforms are not normalized, so a round trip scales by N.
+template <int_t N>
+void expect_fft_round_trip() {
+    aligned_array<std::complex<float>, N> input;
+    aligned_array<float, N> real_input;
+    for (auto i = 0; i < N; ++i) {
+        input[i] = {std::sin(0.3f * i * i), std::cos(0.7f * i)};
+        real_input[i] = input[i].real();
+    }
+    auto const scale = 1.f / N;
+
+    aligned_array<std::complex<float>, N> spectrum;
+    aligned_array<std::complex<float>, N> output;
+    fft::fft<float, N, fft::direction::forward>{}(input, spectrum);
+    fft::fft<float, N, fft::direction::inverse>{}(spectrum, output);
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_NEAR(0., std::abs(input[i] - scale * output[i]), 1e-5) << N;
+    }
+
+    // Errors of the same kind both ways would cancel out in a round trip,
+    // so the inverse is also held to the forward transform of conjugates.
+    aligned_array<std::complex<float>, N> conjugates;
+    aligned_array<std::complex<float>, N> expected;
+    for (auto i = 0; i < N; ++i) {
+        conjugates[i] = std::conj(spectrum[i]);
+    }
+    fft::fft<float, N, fft::direction::forward>{}(conjugates, expected);
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_NEAR(
+            0.,
+            scale * std::abs(std::conj(expected[i]) - output[i]),
+            1e-5
+        ) << N;
+    }
+
+    // simd_fft only goes forward.
+    fft::simd_fft<float, N> simd_fft;
+    simd_fft(input, spectrum);
+    fft::fft<float, N, fft::direction::inverse>{}(spectrum, output);
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_NEAR(0., std::abs(input[i] - scale * output[i]), 1e-5) << N;
+    }
+
+    std::array<std::complex<float>, N/2 + 1> real_spectrum;
+    aligned_array<float, N> real_output;
+    fft::real_fft<float, N, fft::direction::forward>{}(
+        real_input,
+        real_spectrum
+    );
+    fft::real_fft<float, N, fft::direction::inverse>{}(
+        real_spectrum,
+        real_output
+    );
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_NEAR(real_input[i], scale * real_output[i], 1e-5) << N;
+    }
+
+    // Likewise the real inverse starts from the spectrum of the complex
+    // transform.
+    for (auto i = 0; i < N; ++i) {
+        input[i] = real_input[i];
+    }
+    fft::fft<float, N, fft::direction::forward>{}(input, spectrum);
+    std::copy_n(std::cbegin(spectrum), N/2 + 1, std::begin(real_spectrum));
+    fft::real_fft<float, N, fft::direction::inverse>{}(
+        real_spectrum,
+        real_output
+    );
+    for (auto i = 0; i < N; ++i) {
+        EXPECT_NEAR(real_input[i], scale * real_output[i], 1e-5) << N;
+    }
+}
+
+TEST_F(SimdTest, FftRoundTripsAtSeveralSizes) {
+    expect_fft_round_trip<16>();
+    expect_fft_round_trip<32>();
+    expect_fft_round_trip<64>();
+    expect_fft_round_trip<128>();
+    expect_fft_round_trip<256>();
+    expect_fft_round_trip<1024>();
+}
+
+// Distance from the reference in units in the last place of T.
+template <typename T>
+double ulp_error(T value, long double reference) {
+    using limits = std::numeric_limits<T>;
+    auto const exponent = std::max(
+        std::ilogb(reference),
+        limits::min_exponent - 1
+    );
+    auto const ulp = std::ldexp(1.l, exponent - limits::digits + 1);
+    return static_cast<double>(std::fabs(value - reference) / ulp);
+}
+
+template <typename T, typename Fn, typename Reference>
+double max_ulp_error(T first, T last, Fn fn, Reference reference) {
+    auto const n = 4096;
+    auto error = 0.;
+    for (auto i = 0; i < n; i += width<T>) {
+        lane<T> x;
+        for (auto j = 0; j < width<T>; ++j) {
+            x.a[j] = first + (last - first) * (i + j) / n;
+        }
+        auto const y = fn(x);
+        for (auto j = 0; j < width<T>; ++j) {
+            error = std::max(error, ulp_error(y.a[j], reference(x.a[j])));
+        }
+    }
+    return error;
+}
+
+// As max_ulp_error, at the values of T nearest the multiples of pi/2 up to
+// last and at their neighbours, of either sign, where the argument reduction
+// leaves the smallest remainders.
+template <typename T, typename Fn, typename Reference>
+double max_ulp_error_near_multiples(T last, Fn fn, Reference reference) {
+    auto const half_pi = std::acos(-1.l) / 2;
+    auto const above = std::numeric_limits<T>::infinity();
+    std::vector<T> samples;
+    for (long k = 1; k * half_pi <= last; k += 1 + k / 1024) {
+        auto const x = static_cast<T>(k * half_pi);
+        for (auto y : {std::nextafter(x, T{0}), x, std::nextafter(x, above)}) {
+            samples.push_back(y);
+            samples.push_back(-y);
+        }
+    }
+    samples.resize((samples.size() + width<T> - 1) / width<T> * width<T>, T{0});
+
+    auto error = 0.;
+    for (auto i = 0u; i < samples.size(); i += width<T>) {
+        auto const x = load(samples.data() + i);
+        auto const y = fn(x);
+        for (auto j = 0; j < width<T>; ++j) {
+            error = std::max(error, ulp_error(y.a[j], reference(x.a[j])));
+        }
+    }
+    return error;
+}
+
+template <typename T>
+void expect_transcendentals_within_bounds(T atan2_bound, T trig_range) {
+    using ld = long double;
+    EXPECT_LE(max_ulp_error<T>(-80, 80,
+        [](lane<T> x) { return simd::exp(x); },
+        [](ld x) { return std::exp(x); }), 1.5);
+    EXPECT_LE(max_ulp_error<T>(1e-3, 1e3,
+        [](lane<T> x) { return simd::log(x); },
+        [](ld x) { return std::log(x); }), 1.5);
+    EXPECT_LE(max_ulp_error<T>(1e-3, 1e3,
+        [](lane<T> x) { return simd::log10(x); },
+        [](ld x) { return std::log10(x); }), 2.);
+    EXPECT_LE(max_ulp_error<T>(-1000, 1000,
+        [](lane<T> x) { return simd::sin(x); },
+        [](ld x) { return std::sin(x); }), 2.5);
+    EXPECT_LE(max_ulp_error<T>(-1000, 1000,
+        [](lane<T> x) { return simd::cos(x); },
+        [](ld x) { return std::cos(x); }), 2.5);
+    EXPECT_LE(max_ulp_error_near_multiples<T>(trig_range,
+        [](lane<T> x) { return simd::sin(x); },
+        [](ld x) { return std::sin(x); }), 2.5);
+    EXPECT_LE(max_ulp_error_near_multiples<T>(trig_range,
+        [](lane<T> x) { return simd::cos(x); },
+        [](ld x) { return std::cos(x); }), 2.5);
+    EXPECT_LE(max_ulp_error<T>(-10, 10,
+        [](lane<T> y) { return simd::atan2(y, set_lane(T{-3})); },
+        [](ld y) { return std::atan2(y, -3.l); }), atan2_bound);
+    EXPECT_LE(max_ulp_error<T>(-10, 10,
+        [](lane<T> x) { return simd::atan2(set_lane(T{2}), x); },
+        [](ld x) { return std::atan2(2.l, x); }), atan2_bound);
+
+    using limits = std::numeric_limits<T>;
+    EXPECT_EQ(limits::infinity(), simd::exp(set_lane(T{1000})).a[0]);
+    EXPECT_EQ(T{0}, simd::exp(set_lane(T{-1000})).a[0]);
+    EXPECT_EQ(-limits::infinity(), simd::log(set_lane(T{0})).a[0]);
+    EXPECT_TRUE(std::isnan(simd::log(set_lane(T{-1})).a[0]));
+    EXPECT_NEAR(
+        std::log(limits::denorm_min()),
+        simd::log(set_lane(limits::denorm_min())).a[0],
+        1e-3
+    );
+}
+
+TEST_F(SimdTest, TranscendentalsWithinUlpBounds) {
+    expect_transcendentals_within_bounds<float>(3.f, 1000.f);
+    expect_transcendentals_within_bounds<double>(2., std::ldexp(1., 20));
+}
+
+TEST_F(SimdTest, FusedSumsMatchScalarLoops) {
+    std::vector<double> a(1003);
+    std::vector<double> b(a.size());
+    for (auto i = 0u; i < a.size(); ++i) {
+        a[i] = 1000. + std::sin(0.1 * i);
+        b[i] = 2. * a[i] + std::cos(0.3 * i);
+    }
+
+    for (auto offset : {0, 1, 3}) {
+        auto const n = static_cast<int_t>(a.size()) - offset;
+        gsl::span<double const> x(a.data() + offset, n);
+        gsl::span<double const> y(b.data() + offset, n);
+
+        auto dot = 0., distance = 0., weights = 0.;
+        for (auto i = 0; i < n; ++i) {
+            dot += x[i] * y[i];
+            distance += (x[i] - y[i]) * (x[i] - y[i]);
+            weights += y[i];
+        }
+        EXPECT_NEAR(dot, math::dot(x, y), 1e-9 * dot);
+        EXPECT_NEAR(distance, math::squared_distance(x, y), 1e-9 * distance);
+        EXPECT_NEAR(dot / weights, math::weighted_mean(x, y), 1e-9);
+        EXPECT_NEAR(
+            dot,
+            simd::reduce_scalar(
+                [] (auto sum, auto x, auto y) {
+                    return intrinsics::mul_add<double>()(x, y, sum);
+                },
+                intrinsics::add<double>(),
+                0.,
+                x,
+                y
+            ),
+            1e-9 * dot
+        );
+    }
+}
+
+TEST_F(SimdTest, CorrelationSurvivesLargeMeans) {
+    std::vector<float> a(517);
+    std::vector<float> b(a.size());
+    std::vector<float> c(a.size());
+    for (auto i = 0u; i < a.size(); ++i) {
+        a[i] = 10000.f + std::sin(0.05f * i);
+        b[i] = 3.f * a[i] - 5.f;
+        c[i] = -a[i];
+    }
+    gsl::span<float const> x(a);
+    EXPECT_NEAR(1.f, math::correlation(x, gsl::span<float const>(b)), 1e-3f);
+    EXPECT_NEAR(-1.f, math::correlation(x, gsl::span<float const>(c)), 1e-3f);
+}
+
+TEST_F(SimdTest, ExpressionsMatchScalarLoops) {
+    std::vector<float> a(203);
+    std::vector<float> b(a.size());
+    for (auto i = 0u; i < a.size(); ++i) {
+        a[i] = std::sin(0.3f * i);
+        b[i] = 0.01f * i - 1.f;
+    }
+
+    for (auto offset : {0, 1, 3}) {
+        auto const n = static_cast<int_t>(a.size()) - offset;
+        gsl::span<float const> x(a.data() + offset, n);
+        gsl::span<float const> y(b.data() + offset, n);
+
+        std::vector<float> out(n);
+        math::assign(
+            gsl::span<float>(out),
+            math::clamp(math::lazy(x) * 2.f - math::lazy(y), 0.f, 1.f)
+        );
+        auto positive = 0.f, excess = 0.f;
+        for (auto i = 0; i < n; ++i) {
+            EXPECT_EQ(std::min(std::max(2.f * x[i] - y[i], 0.f), 1.f), out[i]);
+            positive += std::max(x[i], 0.f);
+            excess = std::max(excess, std::fdim(x[i], y[i]));
+        }
+        EXPECT_NEAR(positive, math::sum(math::max(math::lazy(x), 0.f)), 1e-4f);
+
+        auto const m = math::max(math::fdim(math::lazy(x), math::lazy(y)));
+        EXPECT_EQ(excess, m.value);
+        EXPECT_EQ(excess, std::fdim(x[m.index], y[m.index]));
+    }
+}
+
+TEST_F(SimdTest, PcmMatchesScalarConversion) {
+    constexpr auto channels = 3u;
+    constexpr auto frames = 203;
+    std::vector<std::int16_t> pcm16(channels * frames);
+    std::vector<std::int32_t> pcm32(pcm16.size());
+    std::vector<math::packed_int24> pcm24(pcm16.size());
+    std::vector<double> expected(pcm16.size());
+    for (auto i = 0u; i < pcm16.size(); ++i) {
+        auto const x = std::sin(0.7 * i);
+        pcm16[i] = static_cast<std::int16_t>(std::lround(x * 32767));
+        pcm32[i] = static_cast<std::int32_t>(std::lround(x * 2147483647.));
+        auto const word = static_cast<std::uint32_t>(std::lround(x * 8388607));
+        pcm24[i] = {{
+            static_cast<std::uint8_t>(word),
+            static_cast<std::uint8_t>(word >> 8),
+            static_cast<std::uint8_t>(word >> 16)
+        }};
+        expected[i] = x;
+    }
+
+    std::vector<float> out(pcm16.size());
+    math::convert(gsl::span<std::int16_t const>(pcm16), gsl::span<float>(out));
+    for (auto i = 0u; i < out.size(); ++i) {
+        EXPECT_NEAR(expected[i], out[i], 1e-4);
+    }
+
+    std::vector<double> dout(pcm32.size());
+    math::convert(
+        gsl::span<std::int32_t const>(pcm32),
+        gsl::span<double>(dout),
+        2.
+    );
+    for (auto i = 0u; i < dout.size(); ++i) {
+        EXPECT_NEAR(2 * expected[i], dout[i], 1e-8);
+    }
+
+    std::array<std::vector<float>, channels> planes;
+    std::array<gsl::span<float>, channels> spans;
+    for (auto c = 0u; c < channels; ++c) {
+        planes[c].resize(frames);
+        spans[c] = gsl::span<float>(planes[c]);
+    }
+    math::deinterleave(gsl::span<math::packed_int24 const>(pcm24), spans);
+    std::vector<float> mono(frames);
+    math::downmix(
+        gsl::span<std::int16_t const>(pcm16),
+        std::array<float, channels>{{.5f, .25f, .25f}},
+        gsl::span<float>(mono)
+    );
+    for (auto f = 0; f < frames; ++f) {
+        for (auto c = 0u; c < channels; ++c) {
+            EXPECT_NEAR(expected[f * channels + c], planes[c][f], 1e-6);
+        }
+        auto const mix = .5 * expected[f * channels]
+            + .25 * expected[f * channels + 1]
+            + .25 * expected[f * channels + 2];
+        EXPECT_NEAR(mix, mono[f], 1e-4);
+    }
+}
+
+TEST_F(SimdTest, PercentileThresholdMatchesSortedNeighbourhoods) {
+    std::vector<float> in(300);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = std::abs(std::sin(0.3f * i)) + ((i % 37) == 0 ? 4.f : 0.f);
+    }
+    auto const n = static_cast<int_t>(in.size());
+
+    auto const expect_threshold = [&] (
+        std::vector<float> const& out,
+        int_t radius,
+        double q
+    ) {
+        std::vector<float> window(static_cast<std::size_t>(2*radius + 1));
+        for (int_t i = 0; i < n; ++i) {
+            for (int_t j = -radius; j <= radius; ++j) {
+                auto const k = std::min(std::max(i + j, int_t{0}), n - 1);
+                window[j + radius] = in[k];
+            }
+            std::sort(std::begin(window), std::end(window));
+            auto const t = window[percentile_rank(window.size(), q)];
+            ASSERT_EQ(std::fdim(in[i], t), out[i]);
+        }
+    };
+
+    std::vector<float> out(in.size());
+    math::median_threshold<3>(
+        gsl::span<float const>(in),
+        gsl::span<float>(out)
+    );
+    expect_threshold(out, 3, 0.5);
+
+    math::percentile_threshold<7>(
+        gsl::span<float const>(in),
+        gsl::span<float>(out),
+        0.9
+    );
+    expect_threshold(out, 7, 0.9);
+
+    math::percentile_threshold<40>(
+        gsl::span<float const>(in),
+        gsl::span<float>(out),
+        0.75
+    );
+    expect_threshold(out, 40, 0.75);
+
+    math::percentile_threshold(
+        gsl::span<float const>(in),
+        gsl::span<float>(out),
+        17,
+        0.25
+    );
+    expect_threshold(out, 17, 0.25);
+}
+
+TEST_F(SimdTest, PrefixSumMatchesPartialSum) {
+    std::vector<double> in(103);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = static_cast<double>((i * 37) % 17) - 5.;
+    }
+    std::vector<double> expected(in.size());
+    std::partial_sum(std::cbegin(in), std::cend(in), std::begin(expected));
+
+    std::vector<double> out(in.size());
+    auto const total = math::prefix_sum(
+        gsl::span<double const>(in),
+        gsl::span<double>(out)
+    );
+    EXPECT_EQ(expected, out);
+    EXPECT_EQ(expected.back(), total);
+
+    std::vector<float> fin(std::cbegin(in), std::cend(in));
+    std::vector<float> fout(fin.size());
+    math::prefix_sum(
+        gsl::span<float const>(fin),
+        gsl::span<float>(fout),
+        2.f
+    );
+    for (auto i = 0u; i < fout.size(); ++i) {
+        EXPECT_EQ(static_cast<float>(expected[i] + 2.), fout[i]);
+    }
+}
+
+// Integer values keep every window sum exact, so the streaming and batch
+// thresholds must match the direct mean of each window bit for bit.
+TEST_F(SimdTest, AdaptiveThresholdMatchesWindowMeans) {
+    std::vector<float> in(9001);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = static_cast<float>((i * 37) % 17 + ((i % 29) == 0 ? 40 : 0));
+    }
+    auto const n = static_cast<int_t>(in.size());
+
+    auto const expect_means = [&] (std::vector<float> const& out, int_t r) {
+        for (int_t i = 0; i < n; ++i) {
+            auto const lo = std::max(i - r, int_t{0});
+            auto const hi = std::min(i + r, n - 1);
+            auto const sum = std::accumulate(
+                std::cbegin(in) + lo,
+                std::cbegin(in) + hi + 1,
+                0.f
+            );
+            auto const mean = sum / static_cast<float>(hi - lo + 1);
+            ASSERT_EQ(std::fdim(in[i], mean), out[i]) << i << " " << r;
+        }
+    };
+
+    for (int_t radius : {0, 1, 4, 37, 200}) {
+        std::vector<float> out(in.size());
+        math::adaptive_threshold(
+            gsl::span<float const>(in),
+            gsl::span<float>(out),
+            radius
+        );
+        expect_means(out, radius);
+
+        math::streaming_threshold<float> threshold(radius);
+        std::fill(std::begin(out), std::end(out), -1.f);
+        int_t written = 0;
+        for (int_t i = 0, chunk = 1; i < n; chunk = chunk * 3 % 131) {
+            auto const m = std::min(chunk, n - i);
+            written += threshold.push(
+                gsl::span<float const>(in).subspan(i, m),
+                gsl::span<float>(out).subspan(written)
+            );
+            i += m;
+        }
+        written += threshold.flush(gsl::span<float>(out).subspan(written));
+        EXPECT_EQ(n, written);
+        expect_means(out, radius);
+    }
+
+    auto data = in;
+    math::adaptive_threshold<4>(gsl::span<float>(data));
+    expect_means(data, 4);
+}
+
+TEST_F(SimdTest, CombFilterMatchesRecursiveStages) {
+    std::array<float, 1200> in;
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = static_cast<float>((i * 37) % 17 + ((i % 23) == 0 ? 40 : 0));
+    }
+
+    auto const expect_stages = [&] (auto out, auto expected) {
+        for (auto i = 0u; i < out.size(); ++i) {
+            EXPECT_NEAR(expected[i], out[i], 1e-5f * expected[i]) << i;
+        }
+    };
+
+    std::array<float, 300> out, expected;
+    math::comb_filter(
+        gsl::span<float const, 1200>(in),
+        gsl::span<float, 300>(out)
+    );
+    math::comb_filter_reference(
+        gsl::span<float const, 1200>(in),
+        gsl::span<float, 300>(expected)
+    );
+    expect_stages(out, expected);
+
+    math::comb_filter(
+        gsl::span<float const, 300>(in.data(), 300),
+        gsl::span<float, 300>(out)
+    );
+    math::comb_filter_reference(
+        gsl::span<float const, 300>(in.data(), 300),
+        gsl::span<float, 300>(expected)
+    );
+    expect_stages(out, expected);
+}
+
+// Windows of periods that are not whole numbers of samples take in part
+// of the samples they start and end in.
+TEST_F(SimdTest, CombFilterTakesFractionalPeriods) {
+    std::vector<double> in(1000);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = std::sin(0.05 * i) + 1.5 + ((i % 37) == 0 ? 3. : 0.);
+    }
+    auto const n = static_cast<double>(in.size());
+
+    auto const box_mean = [&] (double a, double b) {
+        auto sum = 0.;
+        for (auto k = static_cast<int_t>(a); k < b; ++k) {
+            sum += in[k] * (std::min(b, k + 1.) - std::max(a, double(k)));
+        }
+        return sum / (b - a);
+    };
+
+    for (auto const& [m, step] : {
+        std::pair<int_t, double>{300, 1.},
+        {120, 2.5},
+        {77, 0.75}
+    }) {
+        auto multiples = 0;
+        while ((multiples + 1) * (m - 1) * step + multiples + 1 <= n) {
+            ++multiples;
+        }
+
+        std::vector<double> out(m);
+        math::comb_filter(
+            gsl::span<double const>(in),
+            gsl::span<double>(out),
+            step
+        );
+
+        EXPECT_EQ(0., out[0]);
+        for (int_t i = 1; i < m; ++i) {
+            auto expected = 0.;
+            for (int_t s = 1; s <= multiples; ++s) {
+                auto const centre = s * i * step + 0.5;
+                auto const half = (s - 0.5) * step;
+                expected += box_mean(centre - half, centre + half);
+            }
+            EXPECT_NEAR(expected, out[i], 1e-9) << m << " " << i;
+        }
+    }
+}
+
+TEST_F(SimdTest, CombFilterBankMatchesCombFilter) {
+    std::vector<double> in(2000);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = std::sin(0.03 * i) + 1.2 + ((i % 41) == 0 ? 2. : 0.);
+    }
+
+    auto const step = 1.25;
+    std::vector<double> expected(201);
+    math::comb_filter(
+        gsl::span<double const>(in),
+        gsl::span<double>(expected),
+        step
+    );
+
+    // The periods comb_filter scores, but for period 0, in reverse.
+    std::vector<double> periods;
+    for (auto i = expected.size() - 1; i > 0; --i) {
+        periods.push_back(i * step);
+    }
+    auto const multiples = 7;
+    math::comb_filter_bank<double> bank(
+        static_cast<int_t>(in.size()),
+        gsl::span<double const>(periods),
+        multiples,
+        step
+    );
+    EXPECT_EQ(static_cast<int_t>(periods.size()), bank.size());
+    EXPECT_EQ(multiples, bank.multiples());
+
+    std::vector<double> out(periods.size());
+    bank.score(gsl::span<double const>(in), gsl::span<double>(out));
+    for (auto i = 0u; i < out.size(); ++i) {
+        EXPECT_NEAR(expected[expected.size() - 1 - i], out[i], 1e-9) << i;
+    }
+
+    std::vector<math::element<double>> top(5);
+    auto const k = bank.best(
+        gsl::span<double const>(in),
+        gsl::span<math::element<double>>(top)
+    );
+    ASSERT_EQ(5, k);
+    auto sorted = out;
+    std::sort(std::begin(sorted), std::end(sorted), std::greater<double>());
+    for (auto i = 0; i < k; ++i) {
+        EXPECT_EQ(sorted[i], top[i].value);
+        EXPECT_EQ(out[top[i].index], top[i].value);
+    }
+
+    std::vector<math::element<double>> all(periods.size() + 3);
+    EXPECT_EQ(
+        static_cast<int_t>(periods.size()),
+        bank.best(
+            gsl::span<double const>(in),
+            gsl::span<math::element<double>>(all)
+        )
+    );
+}
+
+TEST_F(SimdTest, CombFilterBankTakesShortestPeriod) {
+    std::vector<double> in(64);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = 1. + (i * 37 % 11);
+    }
+
+    // The mean of in over [a, b), each value covering [k, k + 1).
+    auto const mean = [&] (double a, double b) {
+        auto sum = 0.;
+        for (auto k = 0u; k < in.size(); ++k) {
+            auto const overlap = std::min(b, k + 1.) - std::max(a, 1. * k);
+            sum += in[k] * std::max(overlap, 0.);
+        }
+        return sum / (b - a);
+    };
+
+    // 1 - 2 / (2 * 4) puts the start of the last window on sample 0.
+    auto const multiples = 4;
+    std::vector<double> const periods = {0.75, 1., 2.5, 7.25};
+    math::comb_filter_bank<double> bank(
+        static_cast<int_t>(in.size()),
+        gsl::span<double const>(periods),
+        multiples
+    );
+    std::vector<double> out(periods.size());
+    bank.score(gsl::span<double const>(in), gsl::span<double>(out));
+
+    for (auto i = 0u; i < periods.size(); ++i) {
+        auto expected = 0.;
+        for (auto s = 1; s <= multiples; ++s) {
+            auto const centre = s * periods[i] + 0.5;
+            expected += mean(centre - (s - 0.5), centre + (s - 0.5));
+        }
+        EXPECT_NEAR(expected, out[i], 1e-9) << periods[i];
+    }
+}
+
+TEST_F(SimdTest, NormalizationsMatchScalarLoops) {
+    std::vector<double> in(37);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = 1000. + std::sin(0.7 * i) * ((i % 5) + 1) - 0.5;
+    }
+    in[3] = 1003.;
+
+    using loop = std::function<void(std::vector<double>&)>;
+    auto const expect_normalized = [&] (auto normalize, loop reference) {
+        auto expected = in;
+        reference(expected);
+
+        std::vector<double> out(in.size());
+        normalize(gsl::span<double const>(in), gsl::span<double>(out));
+        for (auto i = 0u; i < in.size(); ++i) {
+            auto const& x = expected[i];
+            EXPECT_NEAR(x, out[i], 1e-12 * (1 + std::abs(x))) << i;
+        }
+
+        // In place, over rows of the same frame. The reductions split the
+        // rows where memory is aligned, so the sums may round differently.
+        std::vector<double> rows;
+        for (auto r = 0; r < 3; ++r) {
+            rows.insert(std::end(rows), std::cbegin(in), std::cend(in));
+        }
+        math::normalize_rows(
+            gsl::span<double>(rows),
+            static_cast<int_t>(in.size()),
+            normalize
+        );
+        for (auto i = 0u; i < rows.size(); ++i) {
+            auto const& x = out[i % in.size()];
+            EXPECT_NEAR(x, rows[i], 1e-12 * (1 + std::abs(x))) << i;
+        }
+    };
+
+    auto const scaled_by = [] (auto norm) {
+        return [norm] (std::vector<double>& x) {
+            auto const n = norm(x);
+            for (auto& v : x) {
+                v /= n;
+            }
+        };
+    };
+
+    for (auto shift : {0., -1000.}) {
+        for (auto& v : in) {
+            v += shift;
+        }
+        expect_normalized(
+            [] (auto in, auto out) { math::normalize(in, out); },
+            scaled_by([] (std::vector<double> const& x) {
+                auto sum = 0.;
+                for (auto v : x) {
+                    sum += std::max(v, 0.);
+                }
+                return sum;
+            })
+        );
+        expect_normalized(
+            [] (auto in, auto out) { math::normalize_l2(in, out); },
+            scaled_by([] (std::vector<double> const& x) {
+                return std::sqrt(std::inner_product(
+                    std::cbegin(x), std::cend(x), std::cbegin(x), 0.
+                ));
+            })
+        );
+        expect_normalized(
+            [] (auto in, auto out) { math::normalize_max(in, out); },
+            scaled_by([] (std::vector<double> const& x) {
+                auto top = 0.;
+                for (auto v : x) {
+                    top = std::max(top, std::abs(v));
+                }
+                return top;
+            })
+        );
+        expect_normalized(
+            [] (auto in, auto out) { math::standardize(in, out); },
+            [] (std::vector<double>& x) {
+                auto const n = static_cast<double>(x.size());
+                auto const mean = std::accumulate(
+                    std::cbegin(x), std::cend(x), 0.
+                ) / n;
+                auto variance = 0.;
+                for (auto v : x) {
+                    variance += (v - mean) * (v - mean);
+                }
+                auto const deviation = std::sqrt(variance / n);
+                for (auto& v : x) {
+                    v = (v - mean) / deviation;
+                }
+            }
+        );
+    }
+
+    // The 1000 below the largest vanish next to it.
+    expect_normalized(
+        [] (auto in, auto out) { math::softmax(in, out); },
+        [] (std::vector<double>& x) {
+            auto const top = *std::max_element(std::cbegin(x), std::cend(x));
+            auto sum = 0.;
+            for (auto& v : x) {
+                v = std::exp(v - top);
+                sum += v;
+            }
+            for (auto& v : x) {
+                v /= sum;
+            }
+        }
+    );
+
+    // Zero norms leave the values alone.
+    std::vector<float> silent(19, 0.f), out(19, 1.f);
+    math::normalize(gsl::span<float const>(silent), gsl::span<float>(out));
+    EXPECT_EQ(silent, out);
+    math::normalize_l2(gsl::span<float>(silent));
+    math::normalize_max(gsl::span<float>(silent));
+    EXPECT_EQ(out, silent);
+
+    std::vector<float> negative(19, -2.f);
+    math::normalize(gsl::span<float const>(negative), gsl::span<float>(out));
+    EXPECT_EQ(negative, out);
+    math::standardize(gsl::span<float const>(negative), gsl::span<float>(out));
+    EXPECT_EQ(silent, out);
+}
+
+TEST_F(SimdTest, FindPeaksMatchesBruteForce) {
+    std::vector<float> in(517);
+    for (auto i = 0u; i < in.size(); ++i) {
+        in[i] = static_cast<float>((i * 7919) % 61) + ((i % 45) == 0 ? 70 : 0);
+    }
+    in[200] = in[201] = 200;
+    auto const n = static_cast<int_t>(in.size());
+
+    for (int_t distance : {1, 2, 5, 17}) {
+        std::vector<math::element<float>> expected;
+        for (int_t i = 1; i + 1 < n; ++i) {
+            auto peak = true;
+            for (int_t k = 1; k <= std::max(distance - 1, int_t{1}); ++k) {
+                peak = peak
+                    && (i - k < 0 || in[i - k] < in[i])
+                    && (i + k >= n || in[i + k] <= in[i]);
+            }
+            if (peak) {
+                expected.emplace_back(in[i], static_cast<std::size_t>(i));
+            }
+        }
+        std::stable_sort(
+            std::begin(expected),
+            std::end(expected),
+            [] (auto const& a, auto const& b) { return a.value > b.value; }
+        );
+
+        auto const peaks = math::find_peaks<12, math::nearest_sample>(
+            gsl::span<float const>(in),
+            distance
+        );
+        ASSERT_EQ(std::min<std::size_t>(12, expected.size()), peaks.size());
+        for (auto k = 0u; k < peaks.size(); ++k) {
+            EXPECT_EQ(expected[k].index, peaks[k].index) << distance << " " << k;
+            EXPECT_EQ(expected[k].value, peaks[k].value);
+            EXPECT_EQ(static_cast<float>(peaks[k].index), peaks.position(k));
+        }
+    }
+
+    auto const few = math::find_peaks<600>(gsl::span<float const>(in), 40);
+    EXPECT_LT(few.size(), 600u);
+    EXPECT_EQ(200u, few[0].index);
+    EXPECT_FLOAT_EQ(200.5f, few.position(0));
+}
+
+TEST_F(SimdTest, FindPeaksInterpolatesVertices) {
+    std::vector<double> in(64);
+    for (auto i = 0u; i < in.size(); ++i) {
+        auto const d = i - 20.3;
+        auto const e = i - 41.8;
+        in[i] = std::exp(-d * d / 8) + 0.5 * std::exp(-e * e / 8);
+    }
+
+    auto const gaussian = math::find_peaks<2, math::gaussian_vertex>(
+        gsl::span<double const>(in)
+    );
+    ASSERT_EQ(2u, gaussian.size());
+    EXPECT_NEAR(20.3, gaussian.position(0), 1e-6);
+    EXPECT_NEAR(1., gaussian[0].value, 1e-6);
+    EXPECT_NEAR(41.8, gaussian.position(1), 1e-6);
+    EXPECT_NEAR(0.5, gaussian[1].value, 1e-6);
+
+    for (auto i = 0u; i < in.size(); ++i) {
+        auto const d = i - 30.25;
+        in[i] = 3 - d * d;
+    }
+    auto const parabolic = math::find_peaks<1>(gsl::span<double const>(in));
+    EXPECT_EQ(30u, parabolic[0].index);
+    EXPECT_DOUBLE_EQ(30.25, parabolic.position(0));
+    EXPECT_DOUBLE_EQ(3., parabolic[0].value);
+}
+
+template <typename Picker>
+void expect_onsets_match_brute_force(
+    math::peak_picking<double> const& settings,
+    std::vector<double> const& in,
+    bool median
+) {
+    auto const n = static_cast<std::int64_t>(in.size());
+    auto const x = [&] (std::int64_t i) {
+        return i < 0 ? 0. : in[i];
+    };
+
+    Picker picker(settings);
+    std::vector<math::onset<double>> picked;
+    for (auto value : in) {
+        if (auto const event = picker.push(value)) {
+            picked.push_back(*event);
+        }
+    }
+
+    std::vector<std::int64_t> expected;
+    for (std::int64_t i = 0; i + picker.latency() < n; ++i) {
+        auto highest = 0.;
+        for (auto k = i - settings.pre_max; k <= i + settings.post_max; ++k) {
+            highest = std::max(highest, x(k));
+        }
+        std::vector<double> window;
+        for (auto k = i - settings.pre_average;
+             k <= i + settings.post_average;
+             ++k) {
+            window.push_back(x(k));
+        }
+        double average;
+        if (median) {
+            std::sort(window.begin(), window.end());
+            average = window[percentile_rank(window.size(), 0.5)];
+        } else {
+            average = std::accumulate(window.begin(), window.end(), 0.)
+                / window.size();
+        }
+        if (in[i] == highest
+            && in[i] >= average + settings.delta
+            && (expected.empty() || i - expected.back() > settings.wait)) {
+            expected.push_back(i);
+        }
+    }
+
+    ASSERT_EQ(expected.size(), picked.size());
+    for (auto j = 0u; j < expected.size(); ++j) {
+        auto const i = expected[j];
+        EXPECT_EQ(static_cast<std::uint64_t>(i), picked[j].frame);
+        auto const vertex = math::parabolic_vertex()(x(i - 1), in[i], in[i + 1]);
+        EXPECT_DOUBLE_EQ(vertex.first, picked[j].offset);
+        EXPECT_DOUBLE_EQ(vertex.second, picked[j].strength);
+    }
+}
+
+TEST_F(SimdTest, OnsetPickerMatchesBruteForce) {
+    std::vector<double> in(2000);
+    std::uint32_t state = 7;
+    for (auto i = 0u; i < in.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        in[i] = (state >> 28) + ((i % 23 == 0) ? 12. : 0.);
+    }
+
+    math::peak_picking<double> settings;
+    settings.delta = 0.5;
+    expect_onsets_match_brute_force<math::onset_picker<double>>(
+        settings, in, false
+    );
+    expect_onsets_match_brute_force<
+        math::onset_picker<double, math::window_median<double>>
+    >(settings, in, true);
+
+    settings = {2, 4, 5, 2, 0., 0};
+    expect_onsets_match_brute_force<math::onset_picker<double>>(
+        settings, in, false
+    );
+    settings = {0, 0, 0, 3, 1., 7};
+    expect_onsets_match_brute_force<
+        math::onset_picker<double, math::window_median<double>>
+    >(settings, in, true);
+}
+
+TEST_F(SimdTest, MaxPlusScanMatchesBruteForce) {
+    std::vector<float> onsets(1000);
+    std::uint32_t state = 11;
+    for (auto& x : onsets) {
+        state = state * 1664525u + 1013904223u;
+        x = static_cast<float>(state >> 8) / (1 << 24);
+    }
+
+    for (auto period : {5.3, 23.7}) {
+        math::beat_transition<float> const window(period, 50);
+        auto const lo = window.nearest();
+        auto const hi = window.farthest();
+        auto const n = static_cast<int_t>(onsets.size());
+
+        std::vector<float> scores(n);
+        std::vector<int_t> links(n);
+        math::cumulative_score(
+            gsl::span<float const>(onsets),
+            window,
+            gsl::span<float>(scores),
+            gsl::span<int_t>(links)
+        );
+
+        std::vector<float> expected(n);
+        for (int_t i = 0; i < n; ++i) {
+            auto best = -std::numeric_limits<float>::infinity();
+            int_t link = -1;
+            for (auto p = i - hi; p <= i - lo; ++p) {
+                if (p < 0) {
+                    continue;
+                }
+                auto const candidate = expected[p]
+                    + window.weights()[p - i + hi];
+                if (candidate > best) {
+                    best = candidate;
+                    link = p;
+                }
+            }
+            expected[i] = link < 0 ? onsets[i] : onsets[i] + best;
+            EXPECT_EQ(expected[i], scores[i]) << period << " " << i;
+            EXPECT_EQ(link, links[i]) << period << " " << i;
+        }
+    }
+}
+
+TEST_F(SimdTest, BeatTrackerFollowsPulses) {
+    std::vector<float> onsets(20000);
+    std::uint32_t state = 3;
+    for (auto i = 0u; i < onsets.size(); ++i) {
+        state = state * 1664525u + 1013904223u;
+        onsets[i] = static_cast<float>(state >> 8) / (1 << 26)
+            + (i % 20 == 7 ? 1.f : 0.f);
+    }
+
+    math::beat_transition<float> const window(20);
+    auto const beats = math::track_beats(
+        gsl::span<float const>(onsets),
+        window
+    );
+    ASSERT_EQ(1000u, beats.size());
+    for (auto k = 0u; k < beats.size(); ++k) {
+        EXPECT_EQ(static_cast<int_t>(20 * k + 7), beats[k]);
+    }
+
+    math::beat_tracker<float> tracker(window);
+    std::vector<int_t> streamed;
+    std::vector<int_t> out(onsets.size());
+    for (std::size_t i = 0, m = 1; i < onsets.size(); i += m, m = m % 97 + 7) {
+        m = std::min(m, onsets.size() - i);
+        auto const written = tracker.push(
+            gsl::span<float const>(onsets.data() + i, m),
+            gsl::span<int_t>(out)
+        );
+        streamed.insert(streamed.end(), out.begin(), out.begin() + written);
+    }
+    auto const written = tracker.flush(gsl::span<int_t>(out));
+    streamed.insert(streamed.end(), out.begin(), out.begin() + written);
+    EXPECT_EQ(beats, streamed);
+}
+
+TEST_F(SimdTest, BiquadBankMatchesScalarSections) {
+    constexpr int_t filters = 11;
+    constexpr int_t stages = 2;
+    std::vector<math::biquad<double>> sections;
+    math::biquad_bank<double> bank(filters, stages);
+    math::biquad_bank<double> bands(filters, stages);
+    for (int_t f = 0; f < filters; ++f) {
+        auto const frequency = 0.01 + 0.04 * f;
+        std::array<math::biquad<double>, stages> const cascade = {
+            math::biquad<double>::bandpass(frequency, 2.),
+            f % 2 ? math::biquad<double>::lowpass(frequency * 1.1)
+                  : math::biquad<double>::highpass(frequency * 0.9, 0.9)
+        };
+        for (int_t k = 0; k < stages; ++k) {
+            bank.set(f, k, cascade[k]);
+            bands.set(f, k, cascade[k]);
+            sections.push_back(cascade[k]);
+        }
+    }
+
+    constexpr int_t frames = 1077;
+    std::vector<double> in(frames * filters), mono(frames);
+    std::uint32_t state = 5;
+    for (auto& x : in) {
+        state = state * 1664525u + 1013904223u;
+        x = static_cast<double>(state >> 8) / (1 << 23) - 1;
+    }
+    for (int_t t = 0; t < frames; ++t) {
+        mono[t] = in[t * filters];
+    }
+
+    // Pieces of uneven length, crossing the chunks the bank works in.
+    std::vector<double> out(in.size()), split(in.size());
+    for (int_t t = 0, m = 300; t < frames; t += m, m = 477) {
+        m = std::min(m, frames - t);
+        bank.process(
+            gsl::span<double const>(in.data() + t * filters, m * filters),
+            gsl::span<double>(out.data() + t * filters, m * filters)
+        );
+        bands.split(
+            gsl::span<double const>(mono.data() + t, m),
+            gsl::span<double>(split.data() + t * filters, m * filters)
+        );
+    }
+
+    auto const filter = [&] (int_t f, auto x_at, auto y_at) {
+        std::array<double, 2 * stages> s = {};
+        for (int_t t = 0; t < frames; ++t) {
+            auto x = x_at(t);
+            for (int_t k = 0; k < stages; ++k) {
+                auto const& c = sections[f * stages + k];
+                auto const y = c.b0 * x + s[2*k];
+                s[2*k] = c.b1 * x - c.a1 * y + s[2*k + 1];
+                s[2*k + 1] = c.b2 * x - c.a2 * y;
+                x = y;
+            }
+            EXPECT_NEAR(x, y_at(t), 1e-12) << f << " " << t;
+        }
+    };
+    for (int_t f = 0; f < filters; ++f) {
+        filter(
+            f,
+            [&] (int_t t) { return in[t * filters + f]; },
+            [&] (int_t t) { return out[t * filters + f]; }
+        );
+        filter(
+            f,
+            [&] (int_t t) { return mono[t]; },
+            [&] (int_t t) { return split[t * filters + f]; }
+        );
+    }
+}
+
+TEST_F(SimdTest, BiquadBankFlushesDecayingState) {
+    math::biquad_bank<float> bank(3);
+    for (int_t f = 0; f < 3; ++f) {
+        bank.set(f, 0, math::biquad<float>::lowpass(0.01 * (f + 1)));
+    }
+
+    std::array<float, 3 * 256> block = {};
+    block.fill(1.f);
+    bank.process(gsl::span<float const>(block), gsl::span<float>(block));
+    for (auto i = 0; i < 32; ++i) {
+        block.fill(0.f);
+        bank.process(gsl::span<float const>(block), gsl::span<float>(block));
+        for (auto y : block) {
+            EXPECT_TRUE(
+                y == 0 || std::abs(y) >= std::numeric_limits<float>::min()
+            );
+        }
+    }
+    for (auto y : block) {
+        EXPECT_EQ(0.f, y);
+    }
+}
+
 } // namespace re
 
 int main(int argc, char* argv[]) {